@@ -1,6 +1,41 @@
 #include "ObstacleSpawner.h"
+#include "Mover.h"
+#include "MoverSubsystem.h"
+#include "ObstacleLaneSelector.h"
+#include "ObstacleOriginRebaseSubsystem.h"
+#include "ObstaclePatternLibrary.h"
+#include "ObstaclePoolSubsystem.h"
+#include "ObstacleSpawnerStats.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+#include "Algo/BinarySearch.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/MemStack.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeExit.h"
+#include "Engine/World.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "Tasks/Task.h"
 
+UStaticMesh* FObstacleSpawnInfo::GetStaticMesh() const
+{
+    return StaticMesh ? StaticMesh : SoftStaticMesh.Get();
+}
+
+USkeletalMesh* FObstacleSpawnInfo::GetSkeletalMesh() const
+{
+    return SkeletalMesh ? SkeletalMesh : SoftSkeletalMesh.Get();
+}
+
+UClass* FObstacleSpawnInfo::GetObstacleActorClass() const
+{
+    return ObstacleActorClass ? ObstacleActorClass.Get() : SoftObstacleActorClass.Get();
+}
 
+UClass* FObstacleSpawnInfo::GetPlaneClass() const
+{
+    return PlaneMesh ? PlaneMesh.Get() : SoftPlaneMesh.Get();
+}
 
 // Sets default values
 AObstacleSpawner::AObstacleSpawner()
@@ -14,133 +49,1161 @@ AObstacleSpawner::AObstacleSpawner()
 void AObstacleSpawner::BeginPlay()
 {
     Super::BeginPlay();
+
+    if (RandomSeed != 0)
+    {
+        SpawnRandom.Initialize(RandomSeed);
+    }
+    else
+    {
+        SpawnRandom.GenerateNewSeed();
+    }
+
+    ObstaclePool = GetWorld()->GetSubsystem<UObstaclePoolSubsystem>();
+    if (UMoverSubsystem* MoverSubsystem = GetWorld()->GetSubsystem<UMoverSubsystem>())
+    {
+        MoverMovedHandle = MoverSubsystem->OnMoverMoved.AddUObject(this, &AObstacleSpawner::HandleMoverMoved);
+    }
+    TickLOD = bUseTickLOD ? GetWorld()->GetSubsystem<UObstacleTickLODSubsystem>() : nullptr;
+    if (TickLOD && TickLODBuckets.Num() > 0)
+    {
+        TickLOD->SetBuckets(TickLODBuckets);
+    }
+    if (!PatternLibraryFile.IsEmpty())
+    {
+        PatternLibrary = FObstaclePatternLibrary::Load(FPaths::ProjectContentDir() / PatternLibraryFile);
+    }
+    PrefetchInitialChunks();
+    if (bUseActorPool)
+    {
+        PrewarmPools(SpawnParameters);
+    }
+}
+
+void AObstacleSpawner::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // Only cut the planning task loose, the world is taking the obstacles down with it
+    ChunkPlanner.Reset();
+    CompletedChunkPlans.Reset();
+    AssetPrefetcher.ReleaseAll();
+    if (UMoverSubsystem* MoverSubsystem = GetWorld()->GetSubsystem<UMoverSubsystem>())
+    {
+        MoverSubsystem->OnMoverMoved.Remove(MoverMovedHandle);
+    }
+    Super::EndPlay(EndPlayReason);
 }
 
 // Called every frame
 void AObstacleSpawner::Tick(float DeltaTime)
 {
     Super::Tick(DeltaTime);
+
+    const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+    UpdateObstacles(PlayerPawn != nullptr, PlayerPawn ? PlayerPawn->GetActorLocation().Y : 0.0f);
+}
+
+void AObstacleSpawner::UpdateObstacles(bool bHasPlayer, float PlayerY)
+{
+    if (CompletedChunkPlans.IsValid())
+    {
+        ApplyPlannedChunks(bHasPlayer ? PlayerY : TNumericLimits<float>::Lowest());
+    }
+
+    if (GroundSnapBatches.Num() > 0)
+    {
+        ResolveGroundSnaps(bHasPlayer ? PlayerY : TNumericLimits<float>::Lowest());
+    }
+
+    if (PendingBatches.Num() > 0)
+    {
+        // Without a player nothing is inside the lookahead and only the budget applies
+        ProcessPendingObstacles(bHasPlayer ? PlayerY : TNumericLimits<float>::Lowest());
+    }
+
+    if (ObstacleEntities.Num() > 0)
+    {
+        // Without a player there is no distance to wait for, everything is promoted as the budget allows
+        PromoteObstacleEntities(bHasPlayer ? PlayerY : TNumericLimits<float>::Max());
+    }
+
+    if (AssetPrefetcher.GetNumRequested() > 0)
+    {
+        ReleasedAssetPaths.Reset();
+        AssetPrefetcher.ReleaseIdle(GetWorld()->GetTimeSeconds(), PrefetchReleaseDelay, ReleasedAssetPaths);
+        for (const FSoftObjectPath& Path : ReleasedAssetPaths)
+        {
+            DropParkedUses(Path.ResolveObject());
+        }
+    }
+
+    if (bHasPlayer && bDespawnPassedObstacles && TrackedObstacles.Num() > 0)
+    {
+        DespawnObstaclesBehind(PlayerY);
+    }
+
+    CSV_CUSTOM_STAT(ObstacleSpawner, TrackedObstacles, GetNumTrackedObstacles(), ECsvCustomStatOp::Set);
+}
+
+void AObstacleSpawner::ApplyWorldOffset(const FVector& InOffset, bool bWorldShift)
+{
+    Super::ApplyWorldOffset(InOffset, bWorldShift);
+
+    // Only a world origin shift moves the obstacles, they live in the persistent level rather than ours
+    if (!bWorldShift)
+    {
+        return;
+    }
+
+    // The obstacles themselves were moved by the engine, this only keeps our bookkeeping in step
+    const float DeltaY = InOffset.Y;
+    for (FTrackedObstacle& Obstacle : TrackedObstacles)
+    {
+        Obstacle.Y += DeltaY;
+    }
+    for (FTrackChunk& Chunk : ChunkRing)
+    {
+        Chunk.StartY += DeltaY;
+        Chunk.EndY += DeltaY;
+        for (FTrackedObstacle& Obstacle : Chunk.Obstacles)
+        {
+            Obstacle.Y += DeltaY;
+        }
+    }
+    for (FPendingObstacleBatch& Batch : PendingBatches)
+    {
+        for (FVector& LanePosition : Batch.LanePositions)
+        {
+            LanePosition += InOffset;
+        }
+        for (FObstaclePlacement& Placement : Batch.Placements)
+        {
+            Placement.Y += DeltaY;
+        }
+    }
+    for (FVector& LanePosition : ChunkLanePositions)
+    {
+        LanePosition += InOffset;
+    }
+    for (FGroundSnapBatch& Batch : GroundSnapBatches)
+    {
+        // Traces still in flight run in the old coordinates, their hit Z is moved over when it is read
+        Batch.TraceShiftZ += InOffset.Z;
+        for (FVector& LanePosition : Batch.LanePositions)
+        {
+            LanePosition += InOffset;
+        }
+        for (FObstaclePlacement& Placement : Batch.Placements)
+        {
+            Placement.Y += DeltaY;
+        }
+    }
+    for (FObstacleEntitySource& Source : EntitySources)
+    {
+        for (FVector& LanePosition : Source.LanePositions)
+        {
+            LanePosition += InOffset;
+        }
+    }
+    for (TPair<TObjectKey<AActor>, FActorLaneEntry>& ActorEntry : ActorLaneEntries)
+    {
+        ActorEntry.Value.Y += DeltaY;
+    }
+    ObstacleEntities.ShiftAll(DeltaY);
+    LaneIndex.ShiftAll(DeltaY);
+    InFlightPlanShiftY += DeltaY;
+}
+
+void AObstacleSpawner::RequestOriginRebase()
+{
+    if (!bRebaseWorldOrigin)
+    {
+        return;
+    }
+
+    if (UObstacleOriginRebaseSubsystem* OriginRebase = GetWorld()->GetSubsystem<UObstacleOriginRebaseSubsystem>())
+    {
+        OriginRebase->RequestRebase(OriginRebaseDistance);
+    }
+}
+
+void AObstacleSpawner::PrefetchObstacleTypes(const FObstacleSpawnParameters& Parameters)
+{
+    const double CurrentTime = GetWorld()->GetTimeSeconds();
+    for (const FObstacleSpawnInfo& SpawnInfo : Parameters.ObstacleTypes)
+    {
+        AssetPrefetcher.Prefetch(SpawnInfo, CurrentTime);
+    }
+}
+
+void AObstacleSpawner::DropParkedUses(UObject* Asset)
+{
+    if (!Asset)
+    {
+        return;
+    }
+
+    // Obstacles still on the track keep their asset until they are released, only what is parked goes now
+    ComponentRecycler.DropParked(Asset);
+    if (UStaticMesh* Mesh = Cast<UStaticMesh>(Asset))
+    {
+        InstanceBatcher.DropIdleBatch(Mesh);
+    }
+    if (UClass* ActorClass = Cast<UClass>(Asset); ActorClass && ObstaclePool)
+    {
+        ObstaclePool->DropParked(ActorClass);
+    }
+}
+
+void AObstacleSpawner::PrefetchInitialChunks()
+{
+    if (InitialPrefetchChunks <= 0 || SpawnParameters.ObstacleTypes.Num() == 0)
+    {
+        return;
+    }
+
+    // Plans on a copy of the stream, so the real first plans come out the same and nothing here is kept
+    FootprintCache.GetFootprints(SpawnParameters.ObstacleTypes, TypeFootprints);
+    SyncPlanner.CompileIfChanged(SpawnParameters, TypeFootprints);
+    SyncPlanner.SetPatterns(PatternLibrary, PatternProbability);
+    FRandomStream PreviewRandom = SpawnRandom;
+
+    TBitArray<> UsedTypes(false, SpawnParameters.ObstacleTypes.Num());
+    TArray<FObstaclePlacement> Placements;
+    const int32 LaneCount = FMath::Clamp(PrefetchLaneCount, 1, FObstacleLaneSelector::MaxLanes);
+    float StartY = GetActorLocation().Y;
+    for (int32 Chunk = 0; Chunk < InitialPrefetchChunks; ++Chunk)
+    {
+        StartY = SyncPlanner.Plan(StartY, LaneCount, PreviewRandom, Placements);
+        for (const FObstaclePlacement& Placement : Placements)
+        {
+            UsedTypes[Placement.TypeIndex] = true;
+        }
+    }
+
+    const double CurrentTime = GetWorld()->GetTimeSeconds();
+    for (TConstSetBitIterator<> It(UsedTypes); It; ++It)
+    {
+        AssetPrefetcher.Prefetch(SpawnParameters.ObstacleTypes[It.GetIndex()], CurrentTime);
+    }
+    UE_LOG(LogObstacleSpawner, Verbose, TEXT("Prefetched %d of %d obstacle types for the first %d chunks"), UsedTypes.CountSetBits(), SpawnParameters.ObstacleTypes.Num(), InitialPrefetchChunks);
+}
+
+void AObstacleSpawner::PrewarmPools(const FObstacleSpawnParameters& Parameters)
+{
+    if (!ObstaclePool)
+    {
+        return;
+    }
+
+    for (const FObstacleSpawnInfo& SpawnInfo : Parameters.ObstacleTypes)
+    {
+        // Types still streaming in are not prewarmed, their first uses are pool misses instead
+        ObstaclePool->Prewarm(SpawnInfo.GetObstacleActorClass(), SpawnInfo.PoolPrewarmCount);
+        ObstaclePool->Prewarm(SpawnInfo.GetPlaneClass(), SpawnInfo.PoolPrewarmCount);
+    }
+}
+
+AActor* AObstacleSpawner::SpawnObstacleActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform)
+{
+    SCOPE_CYCLE_COUNTER(STAT_SpawnObstacleActor);
+
+    if (bUseActorPool && ObstaclePool)
+    {
+        if (!bSpawningBatch)
+        {
+            return ObstaclePool->Acquire(ActorClass, Transform);
+        }
+
+        // Pool misses are spawned deferred as well, so a cold pool does not run overlaps and BeginPlay mid-batch
+        bool bNeedsFinishSpawning = false;
+        bool bEnableCollision = false;
+        AActor* PooledActor = ObstaclePool->AcquireDeferred(ActorClass, Transform, bNeedsFinishSpawning, bEnableCollision);
+        if (PooledActor)
+        {
+            FDeferredObstacleSpawn& Deferred = DeferredSpawns.AddDefaulted_GetRef();
+            Deferred.Actor = PooledActor;
+            Deferred.Transform = Transform;
+            Deferred.bFinishSpawning = bNeedsFinishSpawning;
+            Deferred.bEnableCollision = bEnableCollision;
+        }
+        return PooledActor;
+    }
+
+    if (bSpawningBatch)
+    {
+        AActor* DeferredActor = GetWorld()->SpawnActorDeferred<AActor>(ActorClass, Transform);
+        if (DeferredActor)
+        {
+            FDeferredObstacleSpawn& Deferred = DeferredSpawns.AddDefaulted_GetRef();
+            Deferred.Actor = DeferredActor;
+            Deferred.Transform = Transform;
+            Deferred.bFinishSpawning = true;
+            Deferred.bEnableCollision = DeferredActor->GetActorEnableCollision();
+            DeferredActor->SetActorEnableCollision(false);
+        }
+        return DeferredActor;
+    }
+
+    FActorSpawnParameters SpawnParams;
+    return GetWorld()->SpawnActor<AActor>(ActorClass, Transform, SpawnParams);
+}
+
+void AObstacleSpawner::BeginSpawnBatch()
+{
+    check(!bSpawningBatch);
+    bSpawningBatch = true;
+}
+
+void AObstacleSpawner::FinishSpawnBatch()
+{
+    bSpawningBatch = false;
+
+    // Finishing runs BeginPlay, which may spawn more obstacles, so work on our own copy. It lives on the mem stack
+    // and DeferredSpawns keeps its allocation for the next batch
+    FMemMark Mark(FMemStack::Get());
+    TArray<FDeferredObstacleSpawn, TMemStackAllocator<>> Spawns(DeferredSpawns);
+    DeferredSpawns.Reset();
+
+    for (const FDeferredObstacleSpawn& Spawn : Spawns)
+    {
+        if (Spawn.bFinishSpawning && IsValid(Spawn.Actor))
+        {
+            Spawn.Actor->FinishSpawning(Spawn.Transform);
+        }
+    }
+
+    // Collision comes on only now, so every actor runs its overlap update once with the whole batch in place
+    for (const FDeferredObstacleSpawn& Spawn : Spawns)
+    {
+        if (!IsValid(Spawn.Actor))
+        {
+            continue;
+        }
+        if (Spawn.bEnableCollision)
+        {
+            Spawn.Actor->SetActorEnableCollision(true);
+        }
+        // Registered after construction, so tick LOD sees the components Blueprints and construction scripts added
+        if (TickLOD && ActorLaneEntries.Contains(Spawn.Actor))
+        {
+            TickLOD->Register(Spawn.Actor);
+        }
+    }
+}
+
+UPrimitiveComponent* AObstacleSpawner::SpawnStaticMeshComponent(UStaticMesh* Mesh, const FTransform& Transform)
+{
+    SCOPE_CYCLE_COUNTER(STAT_SpawnStaticMeshComponent);
+
+    if (bRecycleMeshComponents)
+    {
+        return ComponentRecycler.AcquireStaticMesh(this, Mesh, Transform);
+    }
+
+    UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(this);
+    MeshComponent->SetStaticMesh(Mesh);
+    MeshComponent->SetWorldTransform(Transform);
+    MeshComponent->RegisterComponent();
+    return MeshComponent;
+}
+
+UPrimitiveComponent* AObstacleSpawner::SpawnSkeletalMeshComponent(USkeletalMesh* Mesh, const FTransform& Transform)
+{
+    SCOPE_CYCLE_COUNTER(STAT_SpawnSkeletalMeshComponent);
+
+    if (bRecycleMeshComponents)
+    {
+        return ComponentRecycler.AcquireSkeletalMesh(this, Mesh, Transform);
+    }
+
+    USkeletalMeshComponent* SkeletalComponent = NewObject<USkeletalMeshComponent>(this);
+    SkeletalComponent->SetSkeletalMesh(Mesh);
+    SkeletalComponent->SetWorldTransform(Transform);
+    SkeletalComponent->RegisterComponent();
+    return SkeletalComponent;
+}
+
+void AObstacleSpawner::TrackObstacle(FTrackedObstacle Obstacle, int32 Lane, const FBox& Bounds, FTrackChunk* Chunk)
+{
+    FLaneObstacle LaneObstacle;
+    LaneObstacle.Actor = Obstacle.Actor;
+    LaneObstacle.Component = Obstacle.Component;
+    LaneObstacle.Lane = Lane;
+    LaneObstacle.MinY = Bounds.IsValid ? Bounds.Min.Y : Obstacle.Y;
+    LaneObstacle.MaxY = Bounds.IsValid ? Bounds.Max.Y : Obstacle.Y;
+    Obstacle.LaneEntryId = LaneIndex.Add(LaneObstacle);
+
+    if (Obstacle.Actor)
+    {
+        // Movers only translate, so the extent is kept relative to the actor and never measured again per step
+        FActorLaneEntry& ActorEntry = ActorLaneEntries.Add(Obstacle.Actor.Get());
+        ActorEntry.LaneEntryId = Obstacle.LaneEntryId;
+        ActorEntry.LocalMinY = LaneObstacle.MinY - Obstacle.Y;
+        ActorEntry.LocalMaxY = LaneObstacle.MaxY - Obstacle.Y;
+        ActorEntry.Y = Obstacle.Y;
+        // Actors of a spawn batch are registered once they are finished, their components are not there before
+        if (TickLOD && !bSpawningBatch)
+        {
+            TickLOD->Register(Obstacle.Actor);
+        }
+        INC_DWORD_STAT(STAT_LiveObstacleActors);
+    }
+    else if (Obstacle.Component)
+    {
+        INC_DWORD_STAT(STAT_LiveObstacleComponents);
+    }
+
+    if (Chunk)
+    {
+        Chunk->Obstacles.Add(Obstacle);
+        return;
+    }
+
+    // Plans run front to back, so this is nearly always an append
+    const int32 InsertIndex = Algo::UpperBoundBy(TrackedObstacles, Obstacle.Y, &FTrackedObstacle::Y);
+    TrackedObstacles.Insert(Obstacle, InsertIndex);
+    INC_DWORD_STAT(STAT_TrackedObstacles);
+}
+
+void AObstacleSpawner::ReleaseObstacle(const FTrackedObstacle& Obstacle)
+{
+    LaneIndex.Remove(Obstacle.LaneEntryId);
+
+    if (Obstacle.Actor)
+    {
+        ActorLaneEntries.Remove(Obstacle.Actor.Get());
+        if (TickLOD)
+        {
+            // Gives the actor its own tick settings back before it is parked or destroyed
+            TickLOD->Unregister(Obstacle.Actor);
+        }
+        DEC_DWORD_STAT(STAT_LiveObstacleActors);
+        if (!IsValid(Obstacle.Actor))
+        {
+            return;
+        }
+        if (bUseActorPool && ObstaclePool)
+        {
+            ObstaclePool->Release(Obstacle.Actor);
+        }
+        else
+        {
+            Obstacle.Actor->Destroy();
+        }
+    }
+    else if (Obstacle.Component)
+    {
+        DEC_DWORD_STAT(STAT_LiveObstacleComponents);
+        if (!IsValid(Obstacle.Component))
+        {
+            return;
+        }
+        if (bRecycleMeshComponents)
+        {
+            ComponentRecycler.Release(Obstacle.Component);
+        }
+        else
+        {
+            Obstacle.Component->DestroyComponent();
+        }
+    }
+    else if (Obstacle.Instance.Mesh)
+    {
+        InstanceBatcher.RemoveInstance(Obstacle.Instance.Mesh, Obstacle.Instance.InstanceIndex);
+    }
+}
+
+void AObstacleSpawner::DespawnObstaclesBehind(float PlayerY)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(AObstacleSpawner::DespawnObstaclesBehind, ObstacleSpawnerChannel);
+    SCOPE_CYCLE_COUNTER(STAT_DespawnPassedObstacles);
+
+    // Sorted by Y, so the sweep stops at the first obstacle that is not far enough behind
+    const float DespawnY = PlayerY - RecycleDistanceBehindPlayer;
+    int32 NumPassed = 0;
+    while (NumPassed < TrackedObstacles.Num() && TrackedObstacles[NumPassed].Y < DespawnY)
+    {
+        ReleaseObstacle(TrackedObstacles[NumPassed]);
+        ++NumPassed;
+    }
+
+    if (NumPassed > 0)
+    {
+        TrackedObstacles.RemoveAt(0, NumPassed, false);
+        DEC_DWORD_STAT_BY(STAT_TrackedObstacles, NumPassed);
+        INC_DWORD_STAT_BY(STAT_DespawnedObstacles, NumPassed);
+        CSV_CUSTOM_STAT(ObstacleSpawner, DespawnedObstacles, NumPassed, ECsvCustomStatOp::Accumulate);
+        UE_LOG(LogObstacleSpawner, Verbose, TEXT("Despawned %d obstacles behind Y %f"), NumPassed, DespawnY);
+    }
 }
 
 TArray<AActor*> AObstacleSpawner::SpawnObstacles(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions)
 {
-    TArray<AActor*> SpawnedActors;
-    TArray<int32> LaneSpawnCount;
-    const int32 LaneCount = 3; // Since LanePositions is a fixed-size array of 3 elements
-    LaneSpawnCount.Init(0, LaneCount);  // Initialize spawn counts for each lane
-    float CurrentYPosition = LanePositions[0].Y; // Start Y position for spawning
-    AActor* PreviouslySpawnedActor = nullptr;
+    // Collected in a scratch array that keeps its allocation, the copy handed back is the only one and sized to fit.
+    // Taken out while in use, a call from a spawned actor's BeginPlay gets an empty array of its own
+    TArray<AActor*> Scratch = MoveTemp(SpawnObstaclesResult);
+    Scratch.Reset();
+    SpawnObstaclesBatch(Parameters, LanePositions, Scratch);
+    TArray<AActor*> SpawnedActors(Scratch);
+    SpawnObstaclesResult = MoveTemp(Scratch);
+    return SpawnedActors;
+}
+
+void AObstacleSpawner::SpawnObstaclesBatch(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<AActor*>& OutSpawnedActors)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(AObstacleSpawner::SpawnObstaclesBatch, ObstacleSpawnerChannel);
+    SCOPE_CYCLE_COUNTER(STAT_SpawnObstacles);
+    CSV_SCOPED_TIMING_STAT(ObstacleSpawner, SpawnObstacles);
+
+    // The plan only lives for this call, the mark hands its memory back on return
+    FMemMark Mark(FMemStack::Get());
+    TArray<FObstaclePlacement, TMemStackAllocator<>> Placements;
+    PlanObstacles(Parameters, LanePositions, Placements);
+
+    // Without a player there is no distance to keep obstacles at, so everything is spawned
+    const APawn* PlayerPawn = bUseObstacleEntities ? UGameplayStatics::GetPlayerPawn(this, 0) : nullptr;
+    if (PlayerPawn)
+    {
+        StoreFarPlacements(Parameters, LanePositions, Placements, INDEX_NONE, PlayerPawn->GetActorLocation().Y + EntityPromotionDistance);
+    }
+
+    const int32 NumActorsBefore = OutSpawnedActors.Num();
+    BeginSpawnBatch();
+    for (const FObstaclePlacement& Placement : Placements)
+    {
+        SpawnPlacement(Placement, Parameters, LanePositions, OutSpawnedActors, nullptr);
+    }
+    FinishSpawnBatch();
+
+    RequestOriginRebase();
+
+    INC_DWORD_STAT_BY(STAT_ObstaclesPerSpawnCall, Placements.Num());
+    CSV_CUSTOM_STAT(ObstacleSpawner, ObstaclesPerSpawnCall, Placements.Num(), ECsvCustomStatOp::Accumulate);
+    UE_LOG(LogObstacleSpawner, Verbose, TEXT("Spawned %d obstacles (%d actors) from Y %f"), Placements.Num(), OutSpawnedActors.Num() - NumActorsBefore, LanePositions.Num() > 0 ? LanePositions[0].Y : 0.0f);
+}
+
+void AObstacleSpawner::SpawnObstaclesIncremental(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions)
+{
+    TArray<FObstaclePlacement> Placements;
+    PlanObstacles(Parameters, LanePositions, Placements);
+    const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+    SnapOrQueuePlacements(Parameters, LanePositions, MoveTemp(Placements), INDEX_NONE, PlayerPawn ? PlayerPawn->GetActorLocation().Y : TNumericLimits<float>::Lowest());
+    RequestOriginRebase();
+}
+
+void AObstacleSpawner::QueuePlacements(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement>&& Placements, int32 ChunkSlot)
+{
+    FPendingObstacleBatch& Batch = PendingBatches.AddDefaulted_GetRef();
+    Batch.ChunkSlot = ChunkSlot;
+    Batch.Parameters = Parameters;
+    Batch.LanePositions = LanePositions;
+    Batch.Placements = MoveTemp(Placements);
+
+    // Only the types the plan actually uses have to be in memory by the time the batch spawns
+    const double CurrentTime = GetWorld()->GetTimeSeconds();
+    for (const FObstaclePlacement& Placement : Batch.Placements)
+    {
+        AssetPrefetcher.Prefetch(Parameters.ObstacleTypes[Placement.TypeIndex], CurrentTime);
+    }
+}
+
+void AObstacleSpawner::SnapOrQueuePlacements(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement>&& Placements, int32 ChunkSlot, float PlayerY)
+{
+    UWorld* World = GetWorld();
+    if (!bSnapObstaclesToGround || Placements.Num() == 0)
+    {
+        QueueSnappedPlacements(Parameters, LanePositions, MoveTemp(Placements), ChunkSlot, PlayerY);
+        return;
+    }
+
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(AObstacleSpawner::SnapOrQueuePlacements, ObstacleSpawnerChannel);
+
+    FGroundSnapBatch& Batch = GroundSnapBatches.AddDefaulted_GetRef();
+    Batch.ChunkSlot = ChunkSlot;
+    Batch.Parameters = Parameters;
+    Batch.LanePositions = LanePositions;
+    Batch.Placements = MoveTemp(Placements);
+    Batch.IssuedFrame = GFrameCounter;
+    Batch.Traces.Reserve(Batch.Placements.Num());
+
+    // Static geometry only, the track does not move and nothing we spawn can be mistaken for it
+    FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ObstacleGroundSnap), false, this);
+    QueryParams.MobilityType = EQueryMobilityType::Static;
+
+    // The physics scene runs these alongside the rest of the frame, ResolveGroundSnaps reads them next frame
+    for (const FObstaclePlacement& Placement : Batch.Placements)
+    {
+        const FVector& LanePosition = Batch.LanePositions[Placement.LaneIndex];
+        const FVector Start(LanePosition.X, Placement.Y, LanePosition.Z + GroundTraceHeight);
+        const FVector End(LanePosition.X, Placement.Y, LanePosition.Z - GroundTraceDepth);
+        Batch.Traces.Add(World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Start, End, GroundTraceChannel, QueryParams));
+    }
+    INC_DWORD_STAT_BY(STAT_GroundSnapTraces, Batch.Traces.Num());
+}
+
+void AObstacleSpawner::QueueSnappedPlacements(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement>&& Placements, int32 ChunkSlot, float PlayerY)
+{
+    // Blueprint batches keep their OnObstaclesSpawned contract, so only chunk stream obstacles become entities here.
+    // Without a player there is no distance to keep them at
+    if (bUseObstacleEntities && ChunkSlot != INDEX_NONE && PlayerY > TNumericLimits<float>::Lowest())
+    {
+        StoreFarPlacements(Parameters, LanePositions, Placements, ChunkSlot, PlayerY + EntityPromotionDistance);
+    }
+    QueuePlacements(Parameters, LanePositions, MoveTemp(Placements), ChunkSlot);
+}
+
+void AObstacleSpawner::ResolveGroundSnaps(float PlayerY)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(AObstacleSpawner::ResolveGroundSnaps, ObstacleSpawnerChannel);
+    SCOPE_CYCLE_COUNTER(STAT_ResolveGroundSnaps);
+
+    UWorld* World = GetWorld();
+    int32 NumResolved = 0;
+    for (; NumResolved < GroundSnapBatches.Num(); ++NumResolved)
+    {
+        FGroundSnapBatch& Batch = GroundSnapBatches[NumResolved];
+        // Batches are in issue order, so once one is from this frame so are the rest
+        if (Batch.IssuedFrame >= GFrameCounter)
+        {
+            break;
+        }
+
+        for (int32 Index = 0; Index < Batch.Placements.Num(); ++Index)
+        {
+            FObstaclePlacement& Placement = Batch.Placements[Index];
+            const FHitResult* Hit = World->QueryTraceData(Batch.Traces[Index], GroundTraceResult) ? FHitResult::GetFirstBlockingHit(GroundTraceResult.OutHits) : nullptr;
+            if (Hit)
+            {
+                Placement.GroundOffsetZ = static_cast<float>(Hit->ImpactPoint.Z + Batch.TraceShiftZ - Batch.LanePositions[Placement.LaneIndex].Z);
+            }
+            else
+            {
+                // No ground under the lane, or the result has expired because the game hitched for several frames
+                INC_DWORD_STAT(STAT_GroundSnapMisses);
+            }
+        }
+
+        QueueSnappedPlacements(Batch.Parameters, Batch.LanePositions, MoveTemp(Batch.Placements), Batch.ChunkSlot, PlayerY);
+    }
+    GroundSnapBatches.RemoveAt(0, NumResolved, false);
+}
+
+void AObstacleSpawner::StartChunkStream(const TArray<FVector>& LanePositions)
+{
+    if (LanePositions.Num() == 0)
+    {
+        return;
+    }
+
+    // Everything from an earlier stream goes back to the pools before the ring is reused
+    StopChunkStream();
+
+    TSharedRef<FObstacleLayoutPlanner, ESPMode::ThreadSafe> Planner = MakeShared<FObstacleLayoutPlanner, ESPMode::ThreadSafe>();
+    FootprintCache.GetFootprints(SpawnParameters.ObstacleTypes, TypeFootprints);
+    Planner->Compile(SpawnParameters, TypeFootprints);
+    Planner->SetPatterns(PatternLibrary, PatternProbability);
+
+    // A fresh queue per stream, a plan still in flight from an earlier stream lands in the old one and is dropped with it
+    ChunkPlanner = Planner;
+    CompletedChunkPlans = MakeShared<TQueue<FPlannedChunk, EQueueMode::Spsc>, ESPMode::ThreadSafe>();
+    ChunkLanePositions = LanePositions;
+    ChunkParameters = SpawnParameters;
+    NextChunkIndex = 0;
+
+    ChunkRing.SetNum(FMath::Max(ChunkRingSize, 2));
+    OldestChunkSlot = 0;
+    NumActiveChunks = 0;
+
+    LaunchChunkPlanning(LanePositions[0].Y);
+}
+
+int32 AObstacleSpawner::GetNumTrackedObstacles() const
+{
+    int32 NumTracked = TrackedObstacles.Num();
+    for (const FTrackChunk& Chunk : ChunkRing)
+    {
+        NumTracked += Chunk.Obstacles.Num();
+    }
+    return NumTracked;
+}
+
+bool AObstacleSpawner::FindNextObstacleInLane(int32 Lane, float Y, FLaneObstacle& OutObstacle) const
+{
+    const FLaneObstacle* Next = LaneIndex.FindNext(Lane, Y);
+    if (!Next)
+    {
+        return false;
+    }
+    OutObstacle = *Next;
+    return true;
+}
+
+void AObstacleSpawner::FindObstaclesInLaneRange(int32 Lane, float MinY, float MaxY, TArray<FLaneObstacle>& OutObstacles) const
+{
+    OutObstacles.Reset();
+    LaneIndex.FindInRange(Lane, MinY, MaxY, OutObstacles);
+}
+
+void AObstacleSpawner::UpdateObstacleExtents(AActor* Obstacle)
+{
+    FActorLaneEntry* ActorEntry = ActorLaneEntries.Find(Obstacle);
+    if (!ActorEntry || !IsValid(Obstacle))
+    {
+        return;
+    }
+
+    // Measured again, the caller may have changed more than the position
+    const FBox Bounds = Obstacle->GetComponentsBoundingBox();
+    const float Y = Obstacle->GetActorLocation().Y;
+    ActorEntry->LocalMinY = Bounds.IsValid ? Bounds.Min.Y - Y : 0.0f;
+    ActorEntry->LocalMaxY = Bounds.IsValid ? Bounds.Max.Y - Y : 0.0f;
+    ActorEntry->Y = Y;
+    LaneIndex.Move(ActorEntry->LaneEntryId, Y + ActorEntry->LocalMinY, Y + ActorEntry->LocalMaxY);
+}
+
+void AObstacleSpawner::HandleMoverMoved(AMover* Mover)
+{
+    // Movers this spawner did not spawn are not in the index
+    FActorLaneEntry* ActorEntry = ActorLaneEntries.Num() > 0 ? ActorLaneEntries.Find(Mover) : nullptr;
+    if (!ActorEntry)
+    {
+        return;
+    }
+
+    // Movers going up and down or across lanes keep their place along the track
+    const float Y = Mover->GetActorLocation().Y;
+    if (Y != ActorEntry->Y)
+    {
+        ActorEntry->Y = Y;
+        LaneIndex.Move(ActorEntry->LaneEntryId, Y + ActorEntry->LocalMinY, Y + ActorEntry->LocalMaxY);
+    }
+}
+
+void AObstacleSpawner::StopChunkStream()
+{
+    ChunkPlanner.Reset();
+    CompletedChunkPlans.Reset();
+
+    // DespawnObstaclesBehind never looks at the ring, so its obstacles and any work still queued for it go now
+    for (int32 Slot = 0; Slot < ChunkRing.Num(); ++Slot)
+    {
+        ReleaseChunk(Slot);
+    }
+    OldestChunkSlot = 0;
+    NumActiveChunks = 0;
+}
+
+void AObstacleSpawner::LaunchChunkPlanning(float StartY)
+{
+    // Seeds are drawn on the game thread so the chunk sequence stays reproducible whatever thread plans it
+    const int32 ChunkSeed = SpawnRandom.RandHelper(MAX_int32);
+    const int32 ChunkIndex = NextChunkIndex++;
+    const int32 LaneCount = FMath::Min(ChunkLanePositions.Num(), FObstacleLaneSelector::MaxLanes);
+    InFlightPlanShiftY = 0.0f;
+
+    // Types still streaming in when the stream started were planned with a placeholder length, pick up their real
+    // footprints as they arrive. The previous task may still hold the old planner, so a changed one is a new copy
+    FootprintCache.GetFootprints(ChunkParameters.ObstacleTypes, TypeFootprints);
+    if (!ChunkPlanner->IsCompiledFor(ChunkParameters, TypeFootprints))
+    {
+        TSharedRef<FObstacleLayoutPlanner, ESPMode::ThreadSafe> Planner = MakeShared<FObstacleLayoutPlanner, ESPMode::ThreadSafe>(*ChunkPlanner);
+        Planner->Compile(ChunkParameters, TypeFootprints);
+        ChunkPlanner = Planner;
+    }
+
+    UE::Tasks::Launch(UE_SOURCE_LOCATION, [Planner = ChunkPlanner, Queue = CompletedChunkPlans, ChunkIndex, ChunkSeed, StartY, LaneCount]()
+    {
+        FRandomStream Random(ChunkSeed);
+        FPlannedChunk Chunk;
+        Chunk.ChunkIndex = ChunkIndex;
+        Chunk.StartY = StartY;
+        Chunk.EndY = Planner->Plan(StartY, LaneCount, Random, Chunk.Placements);
+        Queue->Enqueue(MoveTemp(Chunk));
+    });
+}
+
+void AObstacleSpawner::ApplyPlannedChunks(float PlayerY)
+{
+    if (!CompletedChunkPlans->Peek())
+    {
+        return;
+    }
+
+    // Until the ring is full every plan goes straight in. After that a plan waits until the player has left
+    // the oldest chunk behind, and that chunk is recycled to the front with the new layout
+    int32 Slot = INDEX_NONE;
+    if (NumActiveChunks < ChunkRing.Num())
+    {
+        Slot = (OldestChunkSlot + NumActiveChunks) % ChunkRing.Num();
+        ++NumActiveChunks;
+    }
+    else if (PlayerY > ChunkRing[OldestChunkSlot].EndY + RecycleDistanceBehindPlayer)
+    {
+        Slot = OldestChunkSlot;
+        OldestChunkSlot = (OldestChunkSlot + 1) % ChunkRing.Num();
+        ReleaseChunk(Slot);
+        INC_DWORD_STAT(STAT_RecycledTrackChunks);
+    }
+    else
+    {
+        return;
+    }
+
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(AObstacleSpawner::ApplyPlannedChunks, ObstacleSpawnerChannel);
+    SCOPE_CYCLE_COUNTER(STAT_ApplyPlannedChunk);
+
+    FPlannedChunk PlannedChunk;
+    CompletedChunkPlans->Dequeue(PlannedChunk);
+
+    // Only one plan is ever out at a time, so it takes every shift made since it was launched
+    if (InFlightPlanShiftY != 0.0f)
+    {
+        PlannedChunk.StartY += InFlightPlanShiftY;
+        PlannedChunk.EndY += InFlightPlanShiftY;
+        for (FObstaclePlacement& Placement : PlannedChunk.Placements)
+        {
+            Placement.Y += InFlightPlanShiftY;
+        }
+    }
+
+    FTrackChunk& Chunk = ChunkRing[Slot];
+    Chunk.ChunkIndex = PlannedChunk.ChunkIndex;
+    Chunk.StartY = PlannedChunk.StartY;
+    Chunk.EndY = PlannedChunk.EndY;
+
+    LaunchChunkPlanning(PlannedChunk.EndY);
+    SnapOrQueuePlacements(ChunkParameters, ChunkLanePositions, MoveTemp(PlannedChunk.Placements), Slot, PlayerY);
+
+    // A new chunk is a boundary the shift can happen at without splitting anything
+    RequestOriginRebase();
+}
+
+void AObstacleSpawner::ReleaseChunk(int32 Slot)
+{
+    FTrackChunk& Chunk = ChunkRing[Slot];
+
+    // Obstacles of this chunk that were still waiting for their frame are dropped with it
+    PendingBatches.RemoveAll([Slot](const FPendingObstacleBatch& Batch)
+    {
+        return Batch.ChunkSlot == Slot;
+    });
+    GroundSnapBatches.RemoveAll([Slot](const FGroundSnapBatch& Batch)
+    {
+        return Batch.ChunkSlot == Slot;
+    });
+    for (int32 Source = 0; Source < EntitySources.Num(); ++Source)
+    {
+        if (EntitySources[Source].ChunkSlot == Slot && EntitySources[Source].NumEntities > 0)
+        {
+            ObstacleEntities.RemoveSource(Source);
+            ReleaseEntitySource(Source);
+        }
+    }
+    SET_DWORD_STAT(STAT_ObstacleEntities, ObstacleEntities.Num());
+
+    for (const FTrackedObstacle& Obstacle : Chunk.Obstacles)
+    {
+        ReleaseObstacle(Obstacle);
+    }
+
+    // Reset keeps the allocation, so a recycled chunk does not grow memory
+    Chunk.Obstacles.Reset();
+    Chunk.ChunkIndex = INDEX_NONE;
+}
+
+int32 AObstacleSpawner::GetNumPendingObstacles() const
+{
+    int32 NumPending = 0;
+    for (const FPendingObstacleBatch& Batch : PendingBatches)
+    {
+        NumPending += Batch.Placements.Num() - Batch.NextIndex;
+    }
+    for (const FGroundSnapBatch& Batch : GroundSnapBatches)
+    {
+        NumPending += Batch.Placements.Num();
+    }
+    return NumPending;
+}
+
+void AObstacleSpawner::ProcessPendingObstacles(float PlayerY)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(AObstacleSpawner::ProcessPendingObstacles, ObstacleSpawnerChannel);
+    SCOPE_CYCLE_COUNTER(STAT_ProcessPendingObstacles);
+    CSV_SCOPED_TIMING_STAT(ObstacleSpawner, ProcessPendingObstacles);
+
+    const double StartTime = FPlatformTime::Seconds();
+    const double BudgetSeconds = SpawnBudgetMs * 0.001;
+    const float LookaheadY = PlayerY + SpawnLookaheadDistance;
+    int32 NumSpawnedThisFrame = 0;
+
+    BeginSpawnBatch();
+    while (PendingBatches.Num() > 0)
+    {
+        FPendingObstacleBatch& Batch = PendingBatches[0];
+        while (Batch.NextIndex < Batch.Placements.Num())
+        {
+            const FObstaclePlacement& Placement = Batch.Placements[Batch.NextIndex];
+
+            // Plans run front to back, so once the next obstacle is outside the lookahead the rest can wait for a later frame
+            const bool bOverBudget = NumSpawnedThisFrame > 0 && FPlatformTime::Seconds() - StartTime >= BudgetSeconds;
+            const bool bStillStreaming = !AssetPrefetcher.IsLoaded(Batch.Parameters.ObstacleTypes[Placement.TypeIndex]);
+            if ((bOverBudget || bStillStreaming) && Placement.Y > LookaheadY)
+            {
+                FinishSpawnBatch();
+                SET_DWORD_STAT(STAT_PendingObstaclesSpawnedThisFrame, NumSpawnedThisFrame);
+                SET_FLOAT_STAT(STAT_PendingObstaclesFrameMs, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+                CSV_CUSTOM_STAT(ObstacleSpawner, PendingObstaclesSpawnedThisFrame, NumSpawnedThisFrame, ECsvCustomStatOp::Set);
+                return;
+            }
+
+            FTrackChunk* Chunk = Batch.ChunkSlot != INDEX_NONE ? &ChunkRing[Batch.ChunkSlot] : nullptr;
+            SpawnPlacement(Placement, Batch.Parameters, Batch.LanePositions, Batch.SpawnedActors, Chunk);
+            ++Batch.NextIndex;
+            ++NumSpawnedThisFrame;
+        }
+
+        // Take the batch out before broadcasting, a listener may queue the next one. Listeners get finished actors
+        FPendingObstacleBatch CompletedBatch = MoveTemp(Batch);
+        PendingBatches.RemoveAt(0);
+        FinishSpawnBatch();
+        OnObstaclesSpawned.Broadcast(CompletedBatch.SpawnedActors);
+        RequestOriginRebase();
+        BeginSpawnBatch();
+    }
+    FinishSpawnBatch();
+
+    SET_DWORD_STAT(STAT_PendingObstaclesSpawnedThisFrame, NumSpawnedThisFrame);
+    SET_FLOAT_STAT(STAT_PendingObstaclesFrameMs, (FPlatformTime::Seconds() - StartTime) * 1000.0);
+    CSV_CUSTOM_STAT(ObstacleSpawner, PendingObstaclesSpawnedThisFrame, NumSpawnedThisFrame, ECsvCustomStatOp::Set);
+}
 
-    for (int32 ObstacleIndex = 0; ObstacleIndex < Parameters.NumObstacles; ++ObstacleIndex)
+template <typename AllocatorType>
+void AObstacleSpawner::StoreFarPlacements(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement, AllocatorType>& Placements, int32 ChunkSlot, float PromotionY)
+{
+    int32 Source = INDEX_NONE;
+    int32 NumKept = 0;
+    const double CurrentTime = GetWorld()->GetTimeSeconds();
+    for (const FObstaclePlacement& Placement : Placements)
     {
-        // Find lane with the least spawns
-        int32 MinCount = LaneSpawnCount[0];
-        for (int32 i = 1; i < LaneCount; ++i)
+        if (Placement.Y <= PromotionY)
         {
-            if (LaneSpawnCount[i] < MinCount)
-                MinCount = LaneSpawnCount[i];
+            Placements[NumKept++] = Placement;
+            continue;
         }
 
-        TArray<int32> LeastSpawnedLanes;
-        for (int32 i = 0; i < LaneCount; ++i)
+        // One source for every entity of this call, only taken once there is something to store
+        if (Source == INDEX_NONE)
         {
-            if (LaneSpawnCount[i] == MinCount)
-                LeastSpawnedLanes.Add(i);
+            Source = FreeEntitySources.Num() > 0 ? FreeEntitySources.Pop(false) : EntitySources.AddDefaulted();
+            FObstacleEntitySource& EntitySource = EntitySources[Source];
+            EntitySource.ChunkSlot = ChunkSlot;
+            EntitySource.Parameters = Parameters;
+            EntitySource.LanePositions = LanePositions;
         }
+        ++EntitySources[Source].NumEntities;
+        ObstacleEntities.Add(Placement, Source);
+
+        // The assets get the time until promotion to stream in
+        AssetPrefetcher.Prefetch(Parameters.ObstacleTypes[Placement.TypeIndex], CurrentTime);
+    }
+    Placements.SetNum(NumKept, false);
+    SET_DWORD_STAT(STAT_ObstacleEntities, ObstacleEntities.Num());
+}
+
+void AObstacleSpawner::PromoteObstacleEntities(float PlayerY)
+{
+    // Max when there is no player, everything is then in range
+    const bool bHasPlayer = PlayerY != TNumericLimits<float>::Max();
+    const float PromotionY = bHasPlayer ? PlayerY + EntityPromotionDistance : PlayerY;
+    const int32 NumInRange = ObstacleEntities.NumUpTo(PromotionY);
+    if (NumInRange == 0)
+    {
+        return;
+    }
 
-        // Randomly choose a lane from those with the least spawns
-        int32 LaneIndex = LeastSpawnedLanes[FMath::RandRange(0, LeastSpawnedLanes.Num() - 1)];
-        LaneSpawnCount[LaneIndex]++;  // Increment spawn count for selected lane
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(AObstacleSpawner::PromoteObstacleEntities, ObstacleSpawnerChannel);
+    SCOPE_CYCLE_COUNTER(STAT_PromoteObstacleEntities);
+    CSV_SCOPED_TIMING_STAT(ObstacleSpawner, PromoteObstacleEntities);
 
-        FVector SpawnPosition = FVector(LanePositions[LaneIndex].X, CurrentYPosition, LanePositions[LaneIndex].Z);
+    // Same budget rule as the pending batches: nearest first, and past the budget only what is inside the lookahead.
+    // Without a player nothing is inside it, the budget alone decides and the rest waits for later frames
+    const double StartTime = FPlatformTime::Seconds();
+    const double BudgetSeconds = SpawnBudgetMs * 0.001;
+    const float LookaheadY = bHasPlayer ? PlayerY + SpawnLookaheadDistance : TNumericLimits<float>::Lowest();
 
-        // Calculate the next spawn position based on the previously spawned actor
-        if (PreviouslySpawnedActor)
+    PromotedActors.Reset();
+    int32 NumPromoted = 0;
+    BeginSpawnBatch();
+    for (; NumPromoted < NumInRange; ++NumPromoted)
+    {
+        const FObstaclePlacement Placement = ObstacleEntities.GetPlacement(NumPromoted);
+        const bool bOverBudget = NumPromoted > 0 && FPlatformTime::Seconds() - StartTime >= BudgetSeconds;
+        if (bOverBudget && Placement.Y > LookaheadY)
         {
-            FVector PreviousLocation = PreviouslySpawnedActor->GetActorLocation();
-            CurrentYPosition = PreviousLocation.Y + Parameters.SpacingBetweenObstacles;
-            SpawnPosition.Y = CurrentYPosition;
+            break;
         }
 
-        int32 ObstacleTypeIndex = FMath::RandRange(0, Parameters.ObstacleTypes.Num() - 1);
-        const FObstacleSpawnInfo& SpawnInfo = Parameters.ObstacleTypes[ObstacleTypeIndex];
+        const int32 Source = ObstacleEntities.GetSource(NumPromoted);
+        FObstacleEntitySource& EntitySource = EntitySources[Source];
+        FTrackChunk* Chunk = EntitySource.ChunkSlot != INDEX_NONE ? &ChunkRing[EntitySource.ChunkSlot] : nullptr;
+        SpawnPlacement(Placement, EntitySource.Parameters, EntitySource.LanePositions, PromotedActors, Chunk);
+        if (--EntitySource.NumEntities == 0)
+        {
+            ReleaseEntitySource(Source);
+        }
+    }
+    FinishSpawnBatch();
+    ObstacleEntities.RemoveFront(NumPromoted);
+
+    INC_DWORD_STAT_BY(STAT_PromotedObstacleEntities, NumPromoted);
+    SET_DWORD_STAT(STAT_ObstacleEntities, ObstacleEntities.Num());
+    CSV_CUSTOM_STAT(ObstacleSpawner, PromotedObstacleEntities, NumPromoted, ECsvCustomStatOp::Set);
+    UE_LOG(LogObstacleSpawner, Verbose, TEXT("Promoted %d obstacle entities, %d left"), NumPromoted, ObstacleEntities.Num());
+
+    if (PromotedActors.Num() > 0)
+    {
+        OnObstacleEntitiesPromoted.Broadcast(PromotedActors);
+    }
+}
+
+void AObstacleSpawner::ReleaseEntitySource(int32 Source)
+{
+    // Reset rather than Empty, the next call that stores entities fills the same arrays again
+    FObstacleEntitySource& EntitySource = EntitySources[Source];
+    EntitySource.ChunkSlot = INDEX_NONE;
+    EntitySource.Parameters.ObstacleTypes.Reset();
+    EntitySource.LanePositions.Reset();
+    EntitySource.NumEntities = 0;
+    FreeEntitySources.Add(Source);
+}
+
+int32 AObstacleSpawner::GetNumObstacleEntities() const
+{
+    return ObstacleEntities.Num();
+}
+
+template <typename AllocatorType>
+void AObstacleSpawner::PlanObstacles(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement, AllocatorType>& OutPlacements)
+{
+    OutPlacements.Reset();
+    if (LanePositions.Num() == 0)
+    {
+        return;
+    }
+
+    FootprintCache.GetFootprints(Parameters.ObstacleTypes, TypeFootprints);
+    SyncPlanner.CompileIfChanged(Parameters, TypeFootprints);
+    SyncPlanner.SetPatterns(PatternLibrary, PatternProbability);
+    const int32 LaneCount = FMath::Min(LanePositions.Num(), FObstacleLaneSelector::MaxLanes);
+    SyncPlanner.Plan(LanePositions[0].Y, LaneCount, SpawnRandom, OutPlacements);
+}
+
+void AObstacleSpawner::SpawnPlacement(const FObstaclePlacement& Placement, const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<AActor*>& OutSpawnedActors, FTrackChunk* Chunk)
+{
+    // Timed per type index, so the CSV and trace show which obstacle types are expensive to spawn
+    while (TypeSpawnStatNames.Num() <= Placement.TypeIndex)
+    {
+        const int32 NewTypeIndex = TypeSpawnStatNames.Num();
+        TypeSpawnScopeNames.Add(FString::Printf(TEXT("SpawnObstacleType%d"), NewTypeIndex));
+        TypeSpawnStatNames.Add(FName(*FString::Printf(TEXT("SpawnObstacleType%dMs"), NewTypeIndex)));
+    }
+    TRACE_CPUPROFILER_EVENT_SCOPE_TEXT_ON_CHANNEL(*TypeSpawnScopeNames[Placement.TypeIndex], ObstacleSpawnerChannel);
+#if CSV_PROFILER
+    const uint64 StartCycles = FPlatformTime::Cycles64();
+    ON_SCOPE_EXIT
+    {
+        const float SpawnMs = static_cast<float>(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles));
+        FCsvProfiler::RecordCustomStat(TypeSpawnStatNames[Placement.TypeIndex], CSV_CATEGORY_INDEX(ObstacleSpawner), SpawnMs, ECsvCustomStatOp::Accumulate);
+    };
+#endif
+
+    const FObstacleSpawnInfo& SpawnInfo = Parameters.ObstacleTypes[Placement.TypeIndex];
+    const FVector& LanePosition = LanePositions[Placement.LaneIndex];
+    const FVector SpawnPosition(LanePosition.X, Placement.Y, LanePosition.Z + Placement.GroundOffsetZ);
+    AssetPrefetcher.LoadMissing(SpawnInfo, GetWorld()->GetTimeSeconds());
+
+    UStaticMesh* StaticMesh = SpawnInfo.GetStaticMesh();
+    USkeletalMesh* SkeletalMesh = SpawnInfo.GetSkeletalMesh();
+    UClass* ObstacleActorClass = SpawnInfo.GetObstacleActorClass();
+    UClass* PlaneClass = SpawnInfo.GetPlaneClass();
 
-        FVector ForwardVector;
-        FVector BaseSpawnLocation;
-        // Spawn either a static mesh or a skeletal mesh
-        if (SpawnInfo.StaticMesh)
+    FVector ForwardVector = SpawnInfo.Rotation.Vector();
+    FVector BaseSpawnLocation = SpawnPosition + SpawnInfo.LocationOffset;
+    // Spawn either a static mesh or a skeletal mesh
+    if (StaticMesh)
+    {
+        const FTransform MeshTransform(SpawnInfo.Rotation, SpawnPosition + SpawnInfo.LocationOffset, SpawnInfo.Scale); // Apply the location offset
+        if (bUseInstancedStaticMeshes)
         {
-            UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(this);
-            MeshComponent->SetStaticMesh(SpawnInfo.StaticMesh);
-            MeshComponent->SetWorldLocation(SpawnPosition + SpawnInfo.LocationOffset); // Apply the location offset
-            MeshComponent->SetWorldRotation(SpawnInfo.Rotation);
-            MeshComponent->SetWorldScale3D(SpawnInfo.Scale);
-            MeshComponent->RegisterComponent();
+            SCOPE_CYCLE_COUNTER(STAT_SpawnInstancedObstacle);
+            FTrackedObstacle Tracked;
+            Tracked.Instance.Mesh = StaticMesh;
+            Tracked.Instance.InstanceIndex = InstanceBatcher.AddInstance(this, StaticMesh, MeshTransform);
+            Tracked.Y = MeshTransform.GetLocation().Y;
+            TrackObstacle(Tracked, Placement.LaneIndex, FootprintCache.GetLocalBounds(StaticMesh).TransformBy(MeshTransform), Chunk);
+            ForwardVector = MeshTransform.GetRotation().GetForwardVector();
+            BaseSpawnLocation = MeshTransform.GetLocation();
+        }
+        else
+        {
+            UPrimitiveComponent* MeshComponent = SpawnStaticMeshComponent(StaticMesh, MeshTransform);
+            FTrackedObstacle Tracked;
+            Tracked.Component = MeshComponent;
+            Tracked.Y = MeshTransform.GetLocation().Y;
+            TrackObstacle(Tracked, Placement.LaneIndex, FootprintCache.GetLocalBounds(StaticMesh).TransformBy(MeshTransform), Chunk);
             ForwardVector = MeshComponent->GetForwardVector();
-            
-           
             BaseSpawnLocation = MeshComponent->GetComponentLocation();
         }
-     
-        if (SpawnInfo.ObstacleActorClass)
-        {
-            FActorSpawnParameters SpawnParams;
-           
-            AActor* SpawnedActor = GetWorld()->SpawnActor<AActor>(SpawnInfo.ObstacleActorClass, SpawnPosition, SpawnInfo.Rotation, SpawnParams);
-            SpawnedActor->SetActorScale3D(SpawnInfo.Scale);
-            // Set the location and rotation if needed
-            SpawnedActor->SetActorLocation(SpawnPosition + SpawnInfo.LocationOffset);
-            SpawnedActor->SetActorRotation(SpawnInfo.Rotation);
-           
-          
-            SpawnedActors.Add(SpawnedActor);
-            ForwardVector = SpawnedActor->GetActorForwardVector();
-            BaseSpawnLocation = SpawnedActor->GetActorLocation();
-            PreviouslySpawnedActor = SpawnedActor;
-        
-        }
-        else if (SpawnInfo.SkeletalMesh)
-        {
-            USkeletalMeshComponent* SkeletalComponent = NewObject<USkeletalMeshComponent>(this);
-            SkeletalComponent->SetSkeletalMesh(SpawnInfo.SkeletalMesh);
-            SkeletalComponent->SetWorldLocation(SpawnPosition + SpawnInfo.LocationOffset); // Apply the location offset
-            SkeletalComponent->SetWorldRotation(SpawnInfo.Rotation);
-            SkeletalComponent->SetWorldScale3D(SpawnInfo.Scale);
-            SkeletalComponent->RegisterComponent();
-            ForwardVector = SkeletalComponent->GetForwardVector();
-            
-           
-            BaseSpawnLocation = SkeletalComponent->GetComponentLocation();
-        }
-
-        // Check if this is the train and if a plane should be spawned
-        if (SpawnInfo.PlaneMesh)
-        {
-            float RandomChance = FMath::RandRange(0.0f, 1.0f);
-            if (RandomChance <= SpawnInfo.PlaneSpawnProbability)
-            {
-                // Calculate position in front of the spawned actor for the plane
-              
-                float DistanceInFront = 0.0f; // Distance ahead to spawn the plane
-                FVector PlaneSpawnPosition = BaseSpawnLocation + ForwardVector + SpawnInfo.PlaneLocationOffset;
-                FActorSpawnParameters SpawnParams;
-                
-                // Spawn the plane actor
-                AActor* NewPlaneActor = GetWorld()->SpawnActor<AActor>(SpawnInfo.PlaneMesh, PlaneSpawnPosition, SpawnInfo.PlaneRotation, SpawnParams);
-                NewPlaneActor->SetActorScale3D(SpawnInfo.PlaneScale);
-                
-                NewPlaneActor->SetActorLocation(PlaneSpawnPosition);
-                NewPlaneActor->SetActorRotation(SpawnInfo.PlaneRotation);
-
-                SpawnedActors.Add(NewPlaneActor);
-            }
+    }
+
+    if (ObstacleActorClass)
+    {
+        const FTransform ObstacleTransform(SpawnInfo.Rotation, SpawnPosition + SpawnInfo.LocationOffset, SpawnInfo.Scale);
+        AActor* SpawnedActor = SpawnObstacleActor(ObstacleActorClass, ObstacleTransform);
+        if (SpawnedActor)
+        {
+            FTrackedObstacle Tracked;
+            Tracked.Actor = SpawnedActor;
+            Tracked.Y = ObstacleTransform.GetLocation().Y;
+            TrackObstacle(Tracked, Placement.LaneIndex, FootprintCache.GetLocalBounds(ObstacleActorClass).TransformBy(ObstacleTransform), Chunk);
+
+            // A deferred actor has no components registered yet, its final transform is what it will end up at
+            OutSpawnedActors.Add(SpawnedActor);
+            ForwardVector = ObstacleTransform.GetRotation().GetForwardVector();
+            BaseSpawnLocation = ObstacleTransform.GetLocation();
         }
-       
+    }
+    else if (SkeletalMesh)
+    {
+        const FTransform MeshTransform(SpawnInfo.Rotation, SpawnPosition + SpawnInfo.LocationOffset, SpawnInfo.Scale); // Apply the location offset
+        UPrimitiveComponent* SkeletalComponent = SpawnSkeletalMeshComponent(SkeletalMesh, MeshTransform);
+        FTrackedObstacle Tracked;
+        Tracked.Component = SkeletalComponent;
+        Tracked.Y = MeshTransform.GetLocation().Y;
+        TrackObstacle(Tracked, Placement.LaneIndex, FootprintCache.GetLocalBounds(SkeletalMesh).TransformBy(MeshTransform), Chunk);
+        ForwardVector = SkeletalComponent->GetForwardVector();
+        BaseSpawnLocation = SkeletalComponent->GetComponentLocation();
+    }
+
+    if (PlaneClass && Placement.bSpawnPlane)
+    {
+        // Calculate position in front of the spawned actor for the plane
+        FVector PlaneSpawnPosition = BaseSpawnLocation + ForwardVector + SpawnInfo.PlaneLocationOffset;
 
-        UE_LOG(LogTemp, Warning, TEXT("Spawning Obstacle at Y Position: %f"), CurrentYPosition);
-        CurrentYPosition += Parameters.SpacingBetweenObstacles+500.0f;
-        UE_LOG(LogTemp, Warning, TEXT("Next Obstacle Y Position be: %f"), CurrentYPosition);
-        
+        // Spawn the plane actor
+        SCOPE_CYCLE_COUNTER(STAT_SpawnPlane);
+        const FTransform PlaneTransform(SpawnInfo.PlaneRotation, PlaneSpawnPosition, SpawnInfo.PlaneScale);
+        AActor* NewPlaneActor = SpawnObstacleActor(PlaneClass, PlaneTransform);
+        if (NewPlaneActor)
+        {
+            FTrackedObstacle Tracked;
+            Tracked.Actor = NewPlaneActor;
+            Tracked.Y = PlaneSpawnPosition.Y;
+            TrackObstacle(Tracked, Placement.LaneIndex, FootprintCache.GetLocalBounds(PlaneClass).TransformBy(PlaneTransform), Chunk);
+
+            OutSpawnedActors.Add(NewPlaneActor);
+            INC_DWORD_STAT(STAT_PlaneSpawns);
+            CSV_CUSTOM_STAT(ObstacleSpawner, PlaneSpawns, 1, ECsvCustomStatOp::Accumulate);
+        }
     }
-    return SpawnedActors; 
-}
\ No newline at end of file
+}
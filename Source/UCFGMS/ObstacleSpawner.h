@@ -4,8 +4,21 @@
 #include "GameFramework/Actor.h"
 #include "Components/StaticMeshComponent.h"
 #include "Components/SkeletalMeshComponent.h"
+#include "ObstacleAssetPrefetcher.h"
+#include "ObstacleComponentRecycler.h"
+#include "ObstacleEntityStore.h"
+#include "ObstacleFootprintCache.h"
+#include "ObstacleInstanceBatcher.h"
+#include "ObstacleLaneIndex.h"
+#include "ObstacleLayoutPlanner.h"
+#include "ObstacleTickLODSubsystem.h"
+#include "Containers/Queue.h"
+#include "WorldCollision.h"
 #include "ObstacleSpawner.generated.h"
 
+class AMover;
+class UObstaclePoolSubsystem;
+
 USTRUCT(BlueprintType)
 struct FObstacleSpawnInfo
 {
@@ -16,6 +29,11 @@ struct FObstacleSpawnInfo
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles")
     TSubclassOf<AActor> ObstacleActorClass;
+
+    // How often this type is picked relative to the others, a type with 2 comes up twice as often as one with 1
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles", meta = (ClampMin = "0"))
+    float SpawnWeight = 1.0f;
+
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles")
     float SpacingAfterindevisualObstacles = 0.0f;
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles")
@@ -46,8 +64,35 @@ struct FObstacleSpawnInfo
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles")
     FVector PlaneScale = FVector(1.0f, 1.0f, 1.0f);
-    
 
+    // Actors of ObstacleActorClass and PlaneMesh spawned into the pool when the spawner begins play
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Pool", meta = (ClampMin = "0"))
+    int32 PoolPrewarmCount = 0;
+
+    // Streamed in ahead of use instead of being resident from level load, only used while the hard reference above is empty
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Streaming")
+    TSoftObjectPtr<UStaticMesh> SoftStaticMesh;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Streaming")
+    TSoftObjectPtr<USkeletalMesh> SoftSkeletalMesh;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Streaming")
+    TSoftClassPtr<AActor> SoftObstacleActorClass;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Streaming")
+    TSoftClassPtr<AActor> SoftPlaneMesh;
+
+    // The hard reference if set, otherwise the soft one if it is loaded. Never loads anything
+    UStaticMesh* GetStaticMesh() const;
+    USkeletalMesh* GetSkeletalMesh() const;
+    UClass* GetObstacleActorClass() const;
+    UClass* GetPlaneClass() const;
+
+    // Whether the type has the asset at all, loaded or not
+    bool HasStaticMesh() const { return StaticMesh || !SoftStaticMesh.IsNull(); }
+    bool HasSkeletalMesh() const { return SkeletalMesh || !SoftSkeletalMesh.IsNull(); }
+    bool HasObstacleActorClass() const { return ObstacleActorClass || !SoftObstacleActorClass.IsNull(); }
+    bool HasPlane() const { return PlaneMesh || !SoftPlaneMesh.IsNull(); }
 };
 
 USTRUCT(BlueprintType)
@@ -66,6 +111,131 @@ struct FObstacleSpawnParameters
     TArray<FObstacleSpawnInfo> ObstacleTypes;
 };
 
+// Something the spawner created and has to get rid of again. Exactly one of Actor, Component and Instance is set
+USTRUCT()
+struct FTrackedObstacle
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TObjectPtr<AActor> Actor;
+
+    UPROPERTY()
+    TObjectPtr<UPrimitiveComponent> Component;
+
+    FObstacleInstanceHandle Instance;
+
+    // Y it was spawned at
+    float Y = 0.0f;
+
+    // Entry in the spawner's lane index
+    int32 LaneEntryId = INDEX_NONE;
+};
+
+// One slot of the track chunk ring and everything spawned for it
+USTRUCT()
+struct FTrackChunk
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<FTrackedObstacle> Obstacles;
+
+    int32 ChunkIndex = INDEX_NONE;
+    float StartY = 0.0f;
+    float EndY = 0.0f;
+};
+
+USTRUCT()
+struct FPendingObstacleBatch
+{
+    GENERATED_BODY()
+
+    // Ring slot that owns what this batch spawns, INDEX_NONE for batches queued from Blueprint
+    int32 ChunkSlot = INDEX_NONE;
+
+    UPROPERTY()
+    FObstacleSpawnParameters Parameters;
+
+    UPROPERTY()
+    TArray<FVector> LanePositions;
+
+    UPROPERTY()
+    TArray<AActor*> SpawnedActors;
+
+    TArray<FObstaclePlacement> Placements;
+    int32 NextIndex = 0;
+};
+
+// Placements waiting a frame for the ground traces issued when they were planned
+USTRUCT()
+struct FGroundSnapBatch
+{
+    GENERATED_BODY()
+
+    // Ring slot the placements belong to, INDEX_NONE for batches queued from Blueprint
+    int32 ChunkSlot = INDEX_NONE;
+
+    UPROPERTY()
+    FObstacleSpawnParameters Parameters;
+
+    UPROPERTY()
+    TArray<FVector> LanePositions;
+
+    TArray<FObstaclePlacement> Placements;
+
+    // One per placement, in the same order
+    TArray<FTraceHandle> Traces;
+
+    // Origin shift along Z since the traces were issued, their hits are still in the old coordinates
+    float TraceShiftZ = 0.0f;
+
+    // Results can be read from the frame after this one
+    uint64 IssuedFrame = 0;
+};
+
+// What the obstacle entities planned by one call or chunk need to become actors
+USTRUCT()
+struct FObstacleEntitySource
+{
+    GENERATED_BODY()
+
+    // Ring slot that owns the promoted obstacles, INDEX_NONE for SpawnObstacles calls
+    int32 ChunkSlot = INDEX_NONE;
+
+    UPROPERTY()
+    FObstacleSpawnParameters Parameters;
+
+    UPROPERTY()
+    TArray<FVector> LanePositions;
+
+    // Entities still waiting, the source is free for reuse at 0
+    int32 NumEntities = 0;
+};
+
+// An actor of a spawn batch waiting for its construction to finish and its collision to come on
+struct FDeferredObstacleSpawn
+{
+    AActor* Actor = nullptr;
+    FTransform Transform;
+    // False for pooled actors, those are already constructed
+    bool bFinishSpawning = false;
+    // What the actor's class starts with, collision is off until the batch is finished
+    bool bEnableCollision = false;
+};
+
+// Lane index entry of an actor obstacle, with its extent along the track relative to the actor
+struct FActorLaneEntry
+{
+    int32 LaneEntryId = INDEX_NONE;
+    float LocalMinY = 0.0f;
+    float LocalMaxY = 0.0f;
+    // Actor Y the entry was last placed at
+    float Y = 0.0f;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnObstaclesSpawned, const TArray<AActor*>&, SpawnedActors);
+
 UCLASS()
 class UCFGMS_API AObstacleSpawner : public AActor
 {
@@ -77,19 +247,313 @@ public:
 
     // Called every frame
     virtual void Tick(float DeltaTime) override;
+    virtual void ApplyWorldOffset(const FVector& InOffset, bool bWorldShift) override;
     // Expose the Parameters property to the editor
      // Expose the Parameters property to the editor
     // Expose the SpawnParameters property to the editor
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles")
     FObstacleSpawnParameters SpawnParameters;
+    // Blueprint owns the array this returns, so it costs one allocation when actors were spawned.
+    // C++ callers that reuse an array call SpawnObstaclesBatch instead
     UFUNCTION(BlueprintCallable, Category = "Obstacles")
-     
     TArray<AActor*> SpawnObstacles(const FObstacleSpawnParameters& Parameters,const TArray<FVector>& LanePositions);
-   
+
+    // Spawns every actor deferred at its final transform, then finishes them in one pass. Collision and overlap
+    // updates are held back until the whole batch exists. Spawned actors are appended to OutSpawnedActors, reusing
+    // that array keeps the spawner's side of the call free of heap allocations once pools are warm
+    UFUNCTION(BlueprintCallable, Category = "Obstacles")
+    void SpawnObstaclesBatch(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<AActor*>& OutSpawnedActors);
+
+    // Plans the obstacles now and spawns them over the next frames, OnObstaclesSpawned fires once all of them are in
+    UFUNCTION(BlueprintCallable, Category = "Obstacles")
+    void SpawnObstaclesIncremental(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions);
+
+    // Keeps a ring of ChunkRingSize SpawnParameters chunks along LanePositions. Each chunk is planned on a worker thread,
+    // and the oldest one is recycled to the front once the player has passed it
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Track")
+    void StartChunkStream(const TArray<FVector>& LanePositions);
+
+    // Releases every obstacle of the ring and drops anything still queued, planned or stored for it
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Track")
+    void StopChunkStream();
+
+    // Chunks alive at once in the chunk stream, this caps the obstacles it keeps however long the run is
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Track", meta = (ClampMin = "2"))
+    int32 ChunkRingSize = 4;
+
+    // Obstacles queued by SpawnObstaclesIncremental that are not spawned yet
+    UFUNCTION(BlueprintPure, Category = "Obstacles")
+    int32 GetNumPendingObstacles() const;
+
+    UPROPERTY(BlueprintAssignable, Category = "Obstacles")
+    FOnObstaclesSpawned OnObstaclesSpawned;
+
+    // Time per frame that queued obstacles may take to spawn, at least one obstacle is spawned every frame
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Budget", meta = (ClampMin = "0", Units = "ms"))
+    float SpawnBudgetMs = 2.0f;
+
+    // Queued obstacles closer than this ahead of the player are spawned even when the frame budget is used up
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Budget", meta = (ClampMin = "0"))
+    float SpawnLookaheadDistance = 6000.0f;
+
+    // Keep obstacles planned further than EntityPromotionDistance ahead of the player as plain data, and only spawn
+    // them once the player comes within that distance. SpawnObstacles then returns only the actors it spawned right
+    // away, the rest arrive through OnObstacleEntitiesPromoted. Lane queries see obstacles only once they are promoted
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Entities")
+    bool bUseObstacleEntities = false;
+
+    // Should stay above SpawnLookaheadDistance, otherwise promotions near the player ignore the frame budget
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Entities", meta = (ClampMin = "0"))
+    float EntityPromotionDistance = 20000.0f;
+
+    // Actors spawned this frame for obstacle entities that entered the promotion distance
+    UPROPERTY(BlueprintAssignable, Category = "Obstacles|Entities")
+    FOnObstaclesSpawned OnObstacleEntitiesPromoted;
+
+    UFUNCTION(BlueprintPure, Category = "Obstacles|Entities")
+    int32 GetNumObstacleEntities() const;
+
+    // Put queued and streamed obstacles on the track surface below their lane instead of at the lane's Z. The traces
+    // run asynchronously when the obstacles are planned and are read a frame later, SpawnObstacles spawns right away
+    // and keeps using the lane Z
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Ground")
+    bool bSnapObstaclesToGround = false;
+
+    // Only static geometry on this channel counts as ground, so movers and other obstacles are never hit
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Ground")
+    TEnumAsByte<ECollisionChannel> GroundTraceChannel = ECC_WorldStatic;
+
+    // The trace runs from this far above the lane position...
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Ground", meta = (ClampMin = "0"))
+    float GroundTraceHeight = 500.0f;
+
+    // ...to this far below it. Without a hit the obstacle stays at the lane's Z
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Ground", meta = (ClampMin = "0"))
+    float GroundTraceDepth = 2000.0f;
+
+    // Starts streaming in the soft-referenced assets of every obstacle type in Parameters
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Streaming")
+    void PrefetchObstacleTypes(const FObstacleSpawnParameters& Parameters);
+
+    // BeginPlay plans this many SpawnParameters chunks ahead with a copy of the random stream and prefetches only
+    // the types they use, later chunks prefetch their own types when they are planned
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Streaming", meta = (ClampMin = "0"))
+    int32 InitialPrefetchChunks = 2;
+
+    // Lanes the track is expected to have, so the BeginPlay preview draws the same numbers as the first real plans
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Streaming", meta = (ClampMin = "1", ClampMax = "255"))
+    int32 PrefetchLaneCount = 3;
+
+    // Streamed obstacle assets not needed for this long are released so they can be unloaded
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Streaming", meta = (ClampMin = "0", Units = "s"))
+    float PrefetchReleaseDelay = 60.0f;
+
+    // Seed for lane, type and plane choices so a run can be replayed, 0 picks a new seed every play
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles")
+    int32 RandomSeed = 0;
+
+    // Fills the actor pools with PoolPrewarmCount actors for every obstacle type in Parameters
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Pool")
+    void PrewarmPools(const FObstacleSpawnParameters& Parameters);
+
+    // Take obstacle and plane actors from UObstaclePoolSubsystem instead of spawning new ones
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Pool")
+    bool bUseActorPool = true;
+
+    // Despawn everything this spawner created once it is RecycleDistanceBehindPlayer behind the player
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Pool")
+    bool bDespawnPassedObstacles = true;
+
+    // Obstacles further than this behind the player go back to their pool, or are destroyed when they did not come from one
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Pool", meta = (ClampMin = "0"))
+    float RecycleDistanceBehindPlayer = 3000.0f;
+
+    // Actors, components and instances this spawner currently keeps alive
+    UFUNCTION(BlueprintPure, Category = "Obstacles")
+    int32 GetNumTrackedObstacles() const;
+
+    // The first live obstacle in Lane (an index into the LanePositions it was spawned with) that starts after Y
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Lanes")
+    bool FindNextObstacleInLane(int32 Lane, float Y, FLaneObstacle& OutObstacle) const;
+
+    // Every live obstacle in Lane overlapping MinY to MaxY, in track order
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Lanes")
+    void FindObstaclesInLaneRange(int32 Lane, float MinY, float MaxY, TArray<FLaneObstacle>& OutObstacles) const;
+
+    // Call after moving an obstacle actor along the track so lane queries see its new extent. Movers are kept
+    // up to date by the spawner itself, through UMoverSubsystem::OnMoverMoved
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Lanes")
+    void UpdateObstacleExtents(AActor* Obstacle);
+
+    // Park the static and skeletal mesh components of passed obstacles and reuse them instead of creating new ones
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Pool")
+    bool bRecycleMeshComponents = true;
+
+    // Slow down or suspend the tick of obstacle actors far from the player, see UObstacleTickLODSubsystem.
+    // Covers the movers this spawner spawns, movers placed in the level keep their own tick rate
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Tick LOD")
+    bool bUseTickLOD = true;
+
+    // Replaces the subsystem's default buckets when not empty
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Tick LOD")
+    TArray<FTickLODBucket> TickLODBuckets;
+
+    // At chunk boundaries, move the world origin back under the player once they are OriginRebaseDistance from it.
+    // Blueprints keeping track positions of their own have to shift them in UObstacleOriginRebaseSubsystem::OnWorldOriginShifted
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Origin")
+    bool bRebaseWorldOrigin = false;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Origin", meta = (ClampMin = "0"))
+    float OriginRebaseDistance = 200000.0f;
+
+    // Pattern file exported from a UObstaclePatternSet, relative to the project content directory. Loaded in BeginPlay,
+    // empty plans single obstacles only
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns")
+    FString PatternLibraryFile;
+
+    // Chance that an obstacle slot is filled with a whole pattern from the library
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns", meta = (ClampMin = "0", ClampMax = "1"))
+    float PatternProbability = 0.25f;
+
+    // Draw StaticMesh obstacles as instances of one instanced component per mesh instead of a component each
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Instancing")
+    bool bUseInstancedStaticMeshes = false;
    
 protected:
     // Called when the game starts or when spawned
     virtual void BeginPlay() override;
-    
-   
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+    template <typename AllocatorType>
+    void PlanObstacles(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement, AllocatorType>& OutPlacements);
+    // Everything Tick does for the obstacles, with the player at PlayerY when there is one
+    void UpdateObstacles(bool bHasPlayer, float PlayerY);
+    void SpawnPlacement(const FObstaclePlacement& Placement, const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<AActor*>& OutSpawnedActors, FTrackChunk* Chunk);
+    void QueuePlacements(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement>&& Placements, int32 ChunkSlot);
+    void SnapOrQueuePlacements(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement>&& Placements, int32 ChunkSlot, float PlayerY);
+    void QueueSnappedPlacements(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement>&& Placements, int32 ChunkSlot, float PlayerY);
+    void ResolveGroundSnaps(float PlayerY);
+    void ProcessPendingObstacles(float PlayerY);
+    void PrefetchInitialChunks();
+    // Drops what the recycler, batcher and pool keep parked for an asset the prefetcher released
+    void DropParkedUses(UObject* Asset);
+    template <typename AllocatorType>
+    void StoreFarPlacements(const FObstacleSpawnParameters& Parameters, const TArray<FVector>& LanePositions, TArray<FObstaclePlacement, AllocatorType>& Placements, int32 ChunkSlot, float PromotionY);
+    void PromoteObstacleEntities(float PlayerY);
+    void ReleaseEntitySource(int32 Source);
+    void LaunchChunkPlanning(float StartY);
+    void ApplyPlannedChunks(float PlayerY);
+    AActor* SpawnObstacleActor(TSubclassOf<AActor> ActorClass, const FTransform& Transform);
+    UPrimitiveComponent* SpawnStaticMeshComponent(UStaticMesh* Mesh, const FTransform& Transform);
+    UPrimitiveComponent* SpawnSkeletalMeshComponent(USkeletalMesh* Mesh, const FTransform& Transform);
+    void TrackObstacle(FTrackedObstacle Obstacle, int32 Lane, const FBox& Bounds, FTrackChunk* Chunk);
+    void ReleaseObstacle(const FTrackedObstacle& Obstacle);
+    void ReleaseChunk(int32 Slot);
+    void DespawnObstaclesBehind(float PlayerY);
+    void BeginSpawnBatch();
+    void FinishSpawnBatch();
+    void RequestOriginRebase();
+    void HandleMoverMoved(AMover* Mover);
+
+    UPROPERTY()
+    TObjectPtr<UObstaclePoolSubsystem> ObstaclePool;
+
+    UPROPERTY()
+    TObjectPtr<UObstacleTickLODSubsystem> TickLOD;
+
+    // Everything spawned outside the chunk ring, sorted by Y
+    UPROPERTY()
+    TArray<FTrackedObstacle> TrackedObstacles;
+
+    UPROPERTY()
+    FObstacleComponentRecycler ComponentRecycler;
+
+    UPROPERTY()
+    FObstacleInstanceBatcher InstanceBatcher;
+
+    FObstacleLaneIndex LaneIndex;
+
+    FDelegateHandle MoverMovedHandle;
+
+    // Lane index entries of actor obstacles, for UpdateObstacleExtents and movers
+    TMap<TObjectKey<AActor>, FActorLaneEntry> ActorLaneEntries;
+
+    UPROPERTY()
+    FObstacleFootprintCache FootprintCache;
+
+    // Scratch for the footprints handed to the planners
+    TArray<FBox> TypeFootprints;
+
+    FObstacleAssetPrefetcher AssetPrefetcher;
+
+    // Scratch for the paths ReleaseIdle lets go of
+    TArray<FSoftObjectPath> ReleasedAssetPaths;
+
+    // Scratch SpawnObstacles collects into before copying out
+    TArray<AActor*> SpawnObstaclesResult;
+
+    // Trace scope and CSV stat names of the spawn timing of each type index, built the first time a type spawns
+    TArray<FString> TypeSpawnScopeNames;
+    TArray<FName> TypeSpawnStatNames;
+
+    // Shared with the planners, chunk plans read it from worker threads
+    TSharedPtr<const FObstaclePatternLibrary, ESPMode::ThreadSafe> PatternLibrary;
+
+    FRandomStream SpawnRandom;
+
+    // Planner for SpawnObstacles calls, recompiled only when the parameters it is called with change
+    FObstacleLayoutPlanner SyncPlanner;
+
+    // Actors spawned between BeginSpawnBatch and FinishSpawnBatch. Nothing here outlives the call that opened the batch
+    bool bSpawningBatch = false;
+    TArray<FDeferredObstacleSpawn> DeferredSpawns;
+
+    // Chunk stream state. The planner snapshot and the queue are shared with the planning task,
+    // which is the only producer while the game thread is the only consumer
+    TSharedPtr<const FObstacleLayoutPlanner, ESPMode::ThreadSafe> ChunkPlanner;
+    TSharedPtr<TQueue<FPlannedChunk, EQueueMode::Spsc>, ESPMode::ThreadSafe> CompletedChunkPlans;
+
+    UPROPERTY()
+    FObstacleSpawnParameters ChunkParameters;
+
+    UPROPERTY()
+    TArray<FVector> ChunkLanePositions;
+
+    int32 NextChunkIndex = 0;
+
+    // Origin shift since the chunk plan in flight was launched, it was planned in the coordinates from before
+    float InFlightPlanShiftY = 0.0f;
+
+    UPROPERTY()
+    TArray<FTrackChunk> ChunkRing;
+
+    int32 OldestChunkSlot = 0;
+    int32 NumActiveChunks = 0;
+
+    // Batches queued by SpawnObstaclesIncremental, oldest first
+    UPROPERTY()
+    TArray<FPendingObstacleBatch> PendingBatches;
+
+    // Oldest first, each is queued once its traces are read
+    UPROPERTY()
+    TArray<FGroundSnapBatch> GroundSnapBatches;
+
+    // Reused for every trace result read
+    FTraceDatum GroundTraceResult;
+
+    // Obstacles beyond EntityPromotionDistance, each pointing at one of EntitySources
+    FObstacleEntityStore ObstacleEntities;
+
+    UPROPERTY()
+    TArray<FObstacleEntitySource> EntitySources;
+
+    TArray<int32> FreeEntitySources;
+
+    // Scratch for the actors of one promotion pass
+    TArray<AActor*> PromotedActors;
+
+    // Plays the runner passing each chunk without a player pawn
+    friend class UObstacleSpawnerBenchmarkCommandlet;
+    friend struct FObstacleSpawnerTestAccess;
     };
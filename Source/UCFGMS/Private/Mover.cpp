@@ -2,12 +2,17 @@
 
 
 #include "Mover.h"
+#include "MoverSubsystem.h"
+#include "ObstacleTickLODSubsystem.h"
+#include "Components/SplineComponent.h"
 #include "math/UnrealMathUtility.h"
 // Sets default values
 AMover::AMover()
 {
  	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	// Only ticks while it moves by itself, see StartMove
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 }
 
@@ -16,19 +21,216 @@ void AMover::BeginPlay()
 {
 	Super::BeginPlay();
 	origniallocation=GetActorLocation();
+	BuildSplinePath(false);
+	if(mm)
+	{
+		StartMove();
+	}
+}
+
+void AMover::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Sleep();
+	SplineTable.Reset();
+	// Registered with tick LOD by the spawner that spawned it, when that spawner uses it
+	if(UObstacleTickLODSubsystem* TickLOD=GetWorld()->GetSubsystem<UObstacleTickLODSubsystem>())
+	{
+		TickLOD->Unregister(this);
+	}
+	Super::EndPlay(EndPlayReason);
+}
+
+void AMover::SetMoving(bool bMoving)
+{
+	if(mm==bMoving)
+	{
+		return;
+	}
+
+	// Before BeginPlay the move starts from there
+	if(!HasActorBegunPlay())
+	{
+		mm=bMoving;
+		return;
+	}
+	if(bMoving)
+	{
+		mm=true;
+		StartMove();
+	}
+	else
+	{
+		// Still moving while it works out where it stopped
+		Sleep();
+		mm=false;
+	}
+}
+
+void AMover::RebuildSplinePath()
+{
+	// Carry on from the same distance along the new table
+	float distance=GetPathDistanceAtTime(GetWorld()->GetTimeSeconds());
+	BuildSplinePath(true);
+	MoveStartDistance=SplineTable.IsValid() ? FMath::Min(distance,SplineTable->GetLength()) : 0.0f;
+	if(mm)
+	{
+		StartMove();
+	}
+}
+
+void AMover::BuildSplinePath(bool bRebuild)
+{
+	SplineTable.Reset();
+	USplineComponent* spline=splinepath ? splinepath->FindComponentByClass<USplineComponent>() : nullptr;
+	if(!spline)
+	{
+		return;
+	}
+	if(UMoverSubsystem* MoverSubsystem=GetWorld()->GetSubsystem<UMoverSubsystem>())
+	{
+		SplineTable=MoverSubsystem->GetSplineTable(*spline,splinesamplespacing,bRebuild);
+	}
+	else
+	{
+		TSharedRef<FMoverSplineTable> table=MakeShared<FMoverSplineTable>();
+		table->Build(*spline,splinesamplespacing);
+		SplineTable=table;
+	}
+}
+
+float AMover::GetPathDistanceAtTime(double Time) const
+{
+	if(!SplineTable.IsValid())
+	{
+		return 0.0f;
+	}
+	if(!mm)
+	{
+		return MoveStartDistance;
+	}
+	const double alpha=MoveDuration>0.0 ? FMath::Clamp((Time-MoveStartTime)/MoveDuration,0.0,1.0) : 1.0;
+	return FMath::Lerp(MoveStartDistance,SplineTable->GetLength(),static_cast<float>(alpha));
+}
+
+FVector AMover::GetLocationAtTime(double Time) const
+{
+	if(!mm)
+	{
+		return GetActorLocation();
+	}
+	if(SplineTable.IsValid())
+	{
+		return SplineTable->GetLocationAtDistance(GetPathDistanceAtTime(Time));
+	}
+	const double alpha=MoveDuration>0.0 ? FMath::Clamp((Time-MoveStartTime)/MoveDuration,0.0,1.0) : 1.0;
+	return FMath::Lerp(MoveStartLocation,origniallocation+moveoffset,alpha);
+}
+
+void AMover::StartMove()
+{
+	if(SplineTable.IsValid())
+	{
+		// Resume from MoveStartDistance at the speed that takes movetime for the whole spline
+		float length=SplineTable->GetLength();
+		MoveStartTime=GetWorld()->GetTimeSeconds();
+		MoveDuration=length>UE_KINDA_SMALL_NUMBER ? movetime*(length-MoveStartDistance)/length : 0.0;
+		if(bBatchedMovement)
+		{
+			if(UMoverSubsystem* MoverSubsystem=GetWorld()->GetSubsystem<UMoverSubsystem>())
+			{
+				MoverSubsystem->Wake(this);
+				return;
+			}
+		}
+		SetActorTickEnabled(true);
+		return;
+	}
+
+	FVector targetlocation=origniallocation+moveoffset;
+	float fulldistance=FVector::Distance(origniallocation,targetlocation);
+	MoveStartLocation=GetActorLocation();
+	MoveStartTime=GetWorld()->GetTimeSeconds();
+	// Same constant speed as always: the whole offset takes movetime
+	MoveDuration=fulldistance>UE_KINDA_SMALL_NUMBER ? movetime*FVector::Distance(MoveStartLocation,targetlocation)/fulldistance : 0.0;
+
+	if(bBatchedMovement)
+	{
+		if(UMoverSubsystem* MoverSubsystem=GetWorld()->GetSubsystem<UMoverSubsystem>())
+		{
+			MoverSubsystem->Wake(this);
+			return;
+		}
+	}
+	SetActorTickEnabled(true);
+}
+
+void AMover::Sleep()
+{
+	if(SplineTable.IsValid() && HasActorBegunPlay())
+	{
+		// Remember how far along the spline it got, that is where it resumes
+		MoveStartDistance=GetPathDistanceAtTime(GetWorld()->GetTimeSeconds());
+	}
+	// Also while not in a slot yet, a wake queued during the subsystem's tick has to be cancelled
+	if(bBatchedMovement || MoverSlot!=INDEX_NONE)
+	{
+		if(UMoverSubsystem* MoverSubsystem=GetWorld()->GetSubsystem<UMoverSubsystem>())
+		{
+			MoverSubsystem->Sleep(this);
+		}
+	}
+	SetActorTickEnabled(false);
+}
+
+void AMover::ApplyWorldOffset(const FVector& InOffset, bool bWorldShift)
+{
+	Super::ApplyWorldOffset(InOffset,bWorldShift);
+	// The move goes on between the shifted points, UMoverSubsystem shifts its own copies and the spline tables
+	origniallocation+=InOffset;
+	MoveStartLocation+=InOffset;
+}
+
+void AMover::OnAcquiredFromPool_Implementation()
+{
+	origniallocation=GetActorLocation();
+	MoveStartLocation=origniallocation;
+	MoveStartDistance=0.0f;
+	if(GetClass()->GetDefaultObject<AMover>()->mm)
+	{
+		mm=true;
+		StartMove();
+	}
+}
+
+void AMover::OnParkedInPool_Implementation()
+{
+	Sleep();
+	mm=false;
+	MoveStartDistance=0.0f;
 }
 
 // Called every frame
 void AMover::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
-	if(mm)
+	double now=GetWorld()->GetTimeSeconds();
+	if(SplineTable.IsValid() && bOrientToSpline)
+	{
+		float distance=GetPathDistanceAtTime(now);
+		SetActorLocationAndRotation(SplineTable->GetLocationAtDistance(distance),SplineTable->GetRotationAtDistance(distance));
+	}
+	else
 	{
-		FVector currentlocation=GetActorLocation();
-		FVector targetlocation=origniallocation+moveoffset;
-		float speed=FVector::Distance(origniallocation,targetlocation)/movetime;
-		FVector newlocation=FMath::VInterpConstantTo(currentlocation,targetlocation,DeltaTime,speed);
-		SetActorLocation(newlocation);
+		SetActorLocation(GetLocationAtTime(now));
+	}
+	if(UMoverSubsystem* MoverSubsystem=GetWorld()->GetSubsystem<UMoverSubsystem>())
+	{
+		MoverSubsystem->OnMoverMoved.Broadcast(this);
+	}
+	if(now-MoveStartTime>=MoveDuration)
+	{
+		MoveStartDistance=SplineTable.IsValid() ? SplineTable->GetLength() : 0.0f;
+		// At the target, nothing to do until mm is set again
+		SetActorTickEnabled(false);
 	}
 }
-
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MoverSplineTable.h"
+#include "Components/SplineComponent.h"
+
+void FMoverSplineTable::Build(const USplineComponent& Spline, float InRequestedSpacing)
+{
+	RequestedSpacing = InRequestedSpacing;
+	Length = Spline.GetSplineLength();
+
+	// Round the spacing so the samples end exactly on the end of the spline
+	const int32 NumSamples = FMath::Max(FMath::CeilToInt(Length / FMath::Max(InRequestedSpacing, 1.0f)), 1) + 1;
+	const float SampleSpacing = Length > 0.0f ? Length / (NumSamples - 1) : 1.0f;
+	InvSampleSpacing = 1.0f / SampleSpacing;
+
+	Locations.SetNumUninitialized(NumSamples);
+	Rotations.SetNumUninitialized(NumSamples);
+	for (int32 Index = 0; Index < NumSamples; ++Index)
+	{
+		const float Distance = FMath::Min(Index * SampleSpacing, Length);
+		Locations[Index] = Spline.GetLocationAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World);
+		Rotations[Index] = Spline.GetQuaternionAtDistanceAlongSpline(Distance, ESplineCoordinateSpace::World);
+	}
+}
+
+void FMoverSplineTable::ApplyWorldOffset(const FVector& Offset)
+{
+	for (FVector& Location : Locations)
+	{
+		Location += Offset;
+	}
+}
@@ -0,0 +1,256 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "MoverSubsystem.h"
+#include "Mover.h"
+#include "ObstacleSpawnerStats.h"
+#include "ObstacleTickLODSubsystem.h"
+#include "Engine/World.h"
+
+void UMoverSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+	WorldOriginOffsetHandle = FWorldDelegates::OnPostWorldOriginOffset.AddUObject(this, &UMoverSubsystem::HandleWorldOriginOffset);
+}
+
+void UMoverSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnPostWorldOriginOffset.Remove(WorldOriginOffsetHandle);
+	for (AMover* Mover : Movers)
+	{
+		if (Mover)
+		{
+			Mover->MoverSlot = INDEX_NONE;
+		}
+	}
+	Movers.Empty();
+	Starts.Empty();
+	Targets.Empty();
+	StartTimes.Empty();
+	Durations.Empty();
+	Paths.Empty();
+	PathStartDistances.Empty();
+	OrientToPath.Empty();
+	NextUpdateTimes.Empty();
+	SplineTables.Empty();
+	PendingRequests.Empty();
+	SET_DWORD_STAT(STAT_AwakeMovers, 0);
+	Super::Deinitialize();
+}
+
+TStatId UMoverSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UMoverSubsystem, STATGROUP_Tickables);
+}
+
+void UMoverSubsystem::Wake(AMover* Mover)
+{
+	if (!Mover)
+	{
+		return;
+	}
+	if (bTicking)
+	{
+		PendingRequests.Emplace(Mover, true);
+		return;
+	}
+
+	int32 Slot = Mover->MoverSlot;
+	if (Slot == INDEX_NONE)
+	{
+		Slot = Movers.Add(Mover);
+		Starts.AddUninitialized();
+		Targets.AddUninitialized();
+		StartTimes.AddUninitialized();
+		Durations.AddUninitialized();
+		Paths.AddUninitialized();
+		PathStartDistances.AddUninitialized();
+		OrientToPath.AddUninitialized();
+		NextUpdateTimes.AddUninitialized();
+		Mover->MoverSlot = Slot;
+		INC_DWORD_STAT(STAT_AwakeMovers);
+	}
+
+	Starts[Slot] = Mover->MoveStartLocation;
+	Targets[Slot] = Mover->origniallocation + Mover->moveoffset;
+	StartTimes[Slot] = Mover->MoveStartTime;
+	Durations[Slot] = Mover->MoveDuration;
+	Paths[Slot] = Mover->SplineTable.Get();
+	PathStartDistances[Slot] = Mover->MoveStartDistance;
+	OrientToPath[Slot] = Mover->bOrientToSpline;
+	NextUpdateTimes[Slot] = 0.0;
+}
+
+TSharedRef<const FMoverSplineTable> UMoverSubsystem::GetSplineTable(const USplineComponent& Spline, float SampleSpacing, bool bRebuild)
+{
+	const TSharedRef<FMoverSplineTable>* Cached = SplineTables.Find(&Spline);
+	if (Cached && !bRebuild && (*Cached)->GetRequestedSpacing() == SampleSpacing)
+	{
+		return *Cached;
+	}
+
+	// Movers still holding the old table keep it alive until they pick up the new one
+	TSharedRef<FMoverSplineTable> Table = MakeShared<FMoverSplineTable>();
+	Table->Build(Spline, SampleSpacing);
+	SplineTables.Add(&Spline, Table);
+	return Table;
+}
+
+void UMoverSubsystem::Sleep(AMover* Mover)
+{
+	if (Mover && bTicking)
+	{
+		PendingRequests.Emplace(Mover, false);
+		return;
+	}
+	if (Mover && Movers.IsValidIndex(Mover->MoverSlot) && Movers[Mover->MoverSlot] == Mover)
+	{
+		RemoveSlot(Mover->MoverSlot);
+	}
+}
+
+void UMoverSubsystem::RemoveSlot(int32 Slot)
+{
+	// Swap the last mover into the freed slot so the arrays stay dense
+	Movers[Slot]->MoverSlot = INDEX_NONE;
+	Movers.RemoveAtSwap(Slot, 1, false);
+	Starts.RemoveAtSwap(Slot, 1, false);
+	Targets.RemoveAtSwap(Slot, 1, false);
+	StartTimes.RemoveAtSwap(Slot, 1, false);
+	Durations.RemoveAtSwap(Slot, 1, false);
+	Paths.RemoveAtSwap(Slot, 1, false);
+	PathStartDistances.RemoveAtSwap(Slot, 1, false);
+	OrientToPath.RemoveAtSwap(Slot, 1, false);
+	NextUpdateTimes.RemoveAtSwap(Slot, 1, false);
+	if (Movers.IsValidIndex(Slot))
+	{
+		Movers[Slot]->MoverSlot = Slot;
+	}
+	DEC_DWORD_STAT(STAT_AwakeMovers);
+}
+
+bool UMoverSubsystem::HasPendingRequest(const AMover* Mover) const
+{
+	for (const TPair<TWeakObjectPtr<AMover>, bool>& Request : PendingRequests)
+	{
+		if (Request.Key.Get() == Mover)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UMoverSubsystem::HandleWorldOriginOffset(UWorld* InWorld, FIntVector SrcOrigin, FIntVector DstOrigin)
+{
+	if (InWorld != GetWorld())
+	{
+		return;
+	}
+
+	// The movers themselves were shifted by the engine, their moves only need the same offset to carry on without a jump
+	const FVector Offset(SrcOrigin - DstOrigin);
+	for (int32 Slot = 0; Slot < Movers.Num(); ++Slot)
+	{
+		Starts[Slot] += Offset;
+		Targets[Slot] += Offset;
+	}
+	for (TPair<TObjectKey<USplineComponent>, TSharedRef<FMoverSplineTable>>& Pair : SplineTables)
+	{
+		Pair.Value->ApplyWorldOffset(Offset);
+	}
+}
+
+void UMoverSubsystem::Tick(float DeltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_TickMovers);
+
+	// Moving a mover can fire overlap events that wake or sleep movers, those must not move slots under the loops below
+	bTicking = true;
+
+	// Every move is a straight line at constant speed, so the position follows from the time alone
+	const double Time = GetWorld()->GetTimeSeconds();
+	const UObstacleTickLODSubsystem* TickLOD = GetWorld()->GetSubsystem<UObstacleTickLODSubsystem>();
+	const int32 NumMovers = Movers.Num();
+	Positions.SetNumUninitialized(NumMovers, false);
+	PathDistances.SetNumUninitialized(NumMovers, false);
+	MovedSlots.Reset();
+	ArrivedSlots.Reset();
+	for (int32 Slot = 0; Slot < NumMovers; ++Slot)
+	{
+		// Arrivals always land on time, everything else waits for its next LOD step
+		double Alpha = Durations[Slot] > 0.0 ? (Time - StartTimes[Slot]) / Durations[Slot] : 1.0;
+		if (Alpha >= 1.0)
+		{
+			Alpha = 1.0;
+			ArrivedSlots.Add(Slot);
+		}
+		else if (Time < NextUpdateTimes[Slot])
+		{
+			continue;
+		}
+		else if (TickLOD)
+		{
+			NextUpdateTimes[Slot] = Time + TickLOD->GetUpdateInterval(Movers[Slot]);
+		}
+		MovedSlots.Add(Slot);
+
+		if (const FMoverSplineTable* Path = Paths[Slot])
+		{
+			PathDistances[Slot] = FMath::Lerp(PathStartDistances[Slot], Path->GetLength(), static_cast<float>(Alpha));
+			Positions[Slot] = Path->GetLocationAtDistance(PathDistances[Slot]);
+		}
+		else
+		{
+			Positions[Slot] = FMath::Lerp(Starts[Slot], Targets[Slot], Alpha);
+		}
+	}
+
+	for (const int32 Slot : MovedSlots)
+	{
+		if (Paths[Slot] && OrientToPath[Slot])
+		{
+			Movers[Slot]->SetActorLocationAndRotation(Positions[Slot], Paths[Slot]->GetRotationAtDistance(PathDistances[Slot]));
+		}
+		else
+		{
+			Movers[Slot]->SetActorLocation(Positions[Slot]);
+		}
+		OnMoverMoved.Broadcast(Movers[Slot]);
+	}
+
+	// Highest slot first, so the swaps only pull in movers that are still on their way.
+	// A mover woken or put to sleep this frame already has a newer move, its queued request decides instead
+	for (int32 Index = ArrivedSlots.Num() - 1; Index >= 0; --Index)
+	{
+		const int32 Slot = ArrivedSlots[Index];
+		if (PendingRequests.Num() > 0 && HasPendingRequest(Movers[Slot]))
+		{
+			continue;
+		}
+		if (Paths[Slot])
+		{
+			Movers[Slot]->MoveStartDistance = Paths[Slot]->GetLength();
+		}
+		RemoveSlot(Slot);
+	}
+
+	bTicking = false;
+	for (int32 Index = 0; Index < PendingRequests.Num(); ++Index)
+	{
+		AMover* Mover = PendingRequests[Index].Key.Get();
+		if (!Mover)
+		{
+			continue;
+		}
+		if (PendingRequests[Index].Value)
+		{
+			Wake(Mover);
+		}
+		else
+		{
+			Sleep(Mover);
+		}
+	}
+	PendingRequests.Reset();
+}
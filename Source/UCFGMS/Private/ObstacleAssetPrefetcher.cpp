@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleAssetPrefetcher.h"
+#include "ObstacleSpawner.h"
+#include "ObstacleSpawnerStats.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+
+namespace
+{
+    template <typename FunctorType>
+    void ForEachSoftPath(const FObstacleSpawnInfo& SpawnInfo, FunctorType&& Functor)
+    {
+        // Hard references win, their soft counterpart is never loaded
+        if (!SpawnInfo.StaticMesh && !SpawnInfo.SoftStaticMesh.IsNull())
+        {
+            Functor(SpawnInfo.SoftStaticMesh.ToSoftObjectPath());
+        }
+        if (!SpawnInfo.SkeletalMesh && !SpawnInfo.SoftSkeletalMesh.IsNull())
+        {
+            Functor(SpawnInfo.SoftSkeletalMesh.ToSoftObjectPath());
+        }
+        if (!SpawnInfo.ObstacleActorClass && !SpawnInfo.SoftObstacleActorClass.IsNull())
+        {
+            Functor(SpawnInfo.SoftObstacleActorClass.ToSoftObjectPath());
+        }
+        if (!SpawnInfo.PlaneMesh && !SpawnInfo.SoftPlaneMesh.IsNull())
+        {
+            Functor(SpawnInfo.SoftPlaneMesh.ToSoftObjectPath());
+        }
+    }
+}
+
+FObstacleAssetPrefetcher::~FObstacleAssetPrefetcher()
+{
+    ReleaseAll();
+}
+
+void FObstacleAssetPrefetcher::Prefetch(const FObstacleSpawnInfo& SpawnInfo, double CurrentTime)
+{
+    ForEachSoftPath(SpawnInfo, [this, CurrentTime](const FSoftObjectPath& Path)
+    {
+        Request(Path, CurrentTime);
+    });
+}
+
+bool FObstacleAssetPrefetcher::IsLoaded(const FObstacleSpawnInfo& SpawnInfo) const
+{
+    bool bLoaded = true;
+    ForEachSoftPath(SpawnInfo, [&bLoaded](const FSoftObjectPath& Path)
+    {
+        bLoaded &= Path.ResolveObject() != nullptr;
+    });
+    return bLoaded;
+}
+
+void FObstacleAssetPrefetcher::LoadMissing(const FObstacleSpawnInfo& SpawnInfo, double CurrentTime)
+{
+    ForEachSoftPath(SpawnInfo, [this, CurrentTime](const FSoftObjectPath& Path)
+    {
+        Request(Path, CurrentTime);
+        if (!Path.ResolveObject())
+        {
+            INC_DWORD_STAT(STAT_ObstaclePrefetchMisses);
+            UE_LOG(LogObstacleSpawner, Warning, TEXT("Obstacle asset %s was not prefetched in time and is loaded synchronously"), *Path.ToString());
+            const TSharedPtr<FStreamableHandle>& Handle = Requests[Path].Handle;
+            if (Handle.IsValid())
+            {
+                Handle->WaitUntilComplete();
+            }
+        }
+    });
+}
+
+void FObstacleAssetPrefetcher::ReleaseIdle(double CurrentTime, double MaxIdleSeconds, TArray<FSoftObjectPath>& OutReleased)
+{
+    for (auto It = Requests.CreateIterator(); It; ++It)
+    {
+        if (CurrentTime - It.Value().LastUsedTime > MaxIdleSeconds)
+        {
+            if (It.Value().Handle.IsValid())
+            {
+                It.Value().Handle->ReleaseHandle();
+            }
+            OutReleased.Add(It.Key());
+            It.RemoveCurrent();
+            DEC_DWORD_STAT(STAT_PrefetchedObstacleAssets);
+        }
+    }
+}
+
+void FObstacleAssetPrefetcher::ReleaseAll()
+{
+    for (TPair<FSoftObjectPath, FPrefetchRequest>& Pair : Requests)
+    {
+        if (Pair.Value.Handle.IsValid())
+        {
+            Pair.Value.Handle->ReleaseHandle();
+        }
+    }
+    DEC_DWORD_STAT_BY(STAT_PrefetchedObstacleAssets, Requests.Num());
+    Requests.Empty();
+}
+
+void FObstacleAssetPrefetcher::Request(const FSoftObjectPath& Path, double CurrentTime)
+{
+    FPrefetchRequest& Entry = Requests.FindOrAdd(Path);
+    Entry.LastUsedTime = CurrentTime;
+    if (!Entry.Handle.IsValid())
+    {
+        // Keep a handle even when the asset is already in memory, it is what stops it from being collected while in use
+        Entry.Handle = UAssetManager::GetStreamableManager().RequestAsyncLoad(Path, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+        INC_DWORD_STAT(STAT_PrefetchedObstacleAssets);
+    }
+}
@@ -0,0 +1,127 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleComponentRecycler.h"
+#include "ObstacleSpawnerStats.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Components/StaticMeshComponent.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+
+namespace
+{
+    UObject* GetMeshAsset(UPrimitiveComponent* Component)
+    {
+        if (const UStaticMeshComponent* StaticComponent = Cast<UStaticMeshComponent>(Component))
+        {
+            return StaticComponent->GetStaticMesh();
+        }
+        if (const USkeletalMeshComponent* SkeletalComponent = Cast<USkeletalMeshComponent>(Component))
+        {
+            return SkeletalComponent->GetSkeletalMeshAsset();
+        }
+        return nullptr;
+    }
+}
+
+UStaticMeshComponent* FObstacleComponentRecycler::AcquireStaticMesh(AActor* Owner, UStaticMesh* Mesh, const FTransform& Transform)
+{
+    if (UStaticMeshComponent* Recycled = Cast<UStaticMeshComponent>(Unpark(Mesh, Transform)))
+    {
+        return Recycled;
+    }
+
+    UStaticMeshComponent* MeshComponent = NewObject<UStaticMeshComponent>(Owner);
+    MeshComponent->SetStaticMesh(Mesh);
+    MeshComponent->SetWorldTransform(Transform);
+    MeshComponent->RegisterComponent();
+    INC_DWORD_STAT(STAT_RecycledComponentMisses);
+    return MeshComponent;
+}
+
+USkeletalMeshComponent* FObstacleComponentRecycler::AcquireSkeletalMesh(AActor* Owner, USkeletalMesh* Mesh, const FTransform& Transform)
+{
+    if (USkeletalMeshComponent* Recycled = Cast<USkeletalMeshComponent>(Unpark(Mesh, Transform)))
+    {
+        return Recycled;
+    }
+
+    USkeletalMeshComponent* SkeletalComponent = NewObject<USkeletalMeshComponent>(Owner);
+    SkeletalComponent->SetSkeletalMesh(Mesh);
+    SkeletalComponent->SetWorldTransform(Transform);
+    SkeletalComponent->RegisterComponent();
+    INC_DWORD_STAT(STAT_RecycledComponentMisses);
+    return SkeletalComponent;
+}
+
+void FObstacleComponentRecycler::Release(UPrimitiveComponent* Component)
+{
+    UObject* MeshAsset = IsValid(Component) ? GetMeshAsset(Component) : nullptr;
+    if (!MeshAsset)
+    {
+        return;
+    }
+
+    FParkedObstacleComponents* Entry = Parked.Find(MeshAsset);
+    if (!Entry)
+    {
+        Entry = &Parked.Add(MeshAsset);
+        Entry->ActiveCollision = Component->GetCollisionEnabled();
+    }
+
+    Component->SetHiddenInGame(true);
+    Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+    Component->SetComponentTickEnabled(false);
+    Entry->Components.Add(Component);
+
+    ++NumParked;
+    INC_DWORD_STAT(STAT_ParkedComponents);
+}
+
+void FObstacleComponentRecycler::DropParked(UObject* MeshAsset)
+{
+    FParkedObstacleComponents Entry;
+    if (!Parked.RemoveAndCopyValue(MeshAsset, Entry))
+    {
+        return;
+    }
+
+    for (UPrimitiveComponent* Component : Entry.Components)
+    {
+        if (IsValid(Component))
+        {
+            Component->DestroyComponent();
+        }
+    }
+    NumParked -= Entry.Components.Num();
+    DEC_DWORD_STAT_BY(STAT_ParkedComponents, Entry.Components.Num());
+}
+
+UPrimitiveComponent* FObstacleComponentRecycler::Unpark(UObject* MeshAsset, const FTransform& Transform)
+{
+    FParkedObstacleComponents* Entry = Parked.Find(MeshAsset);
+    if (!Entry)
+    {
+        return nullptr;
+    }
+
+    while (Entry->Components.Num() > 0)
+    {
+        UPrimitiveComponent* Component = Entry->Components.Pop(false);
+        --NumParked;
+        DEC_DWORD_STAT(STAT_ParkedComponents);
+        if (!IsValid(Component) || !Component->IsRegistered())
+        {
+            continue;
+        }
+
+        // The component keeps its render and physics state while parked, so only the transform has to change
+        Component->SetWorldTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+        Component->SetHiddenInGame(false);
+        Component->SetCollisionEnabled(Entry->ActiveCollision);
+        Component->SetComponentTickEnabled(Component->PrimaryComponentTick.bStartWithTickEnabled);
+        INC_DWORD_STAT(STAT_RecycledComponentHits);
+        return Component;
+    }
+    return nullptr;
+}
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleEntityStore.h"
+#include "Algo/BinarySearch.h"
+
+void FObstacleEntityStore::Add(const FObstaclePlacement& Placement, int32 Source)
+{
+    // Plans come in front to back and further ahead than anything stored, so this is nearly always an append
+    const int32 Index = Y.Num() == 0 || Y.Last() <= Placement.Y ? Y.Num() : Algo::UpperBound(Y, Placement.Y);
+    Y.Insert(Placement.Y, Index);
+    GroundOffsetZ.Insert(Placement.GroundOffsetZ, Index);
+    TypeIndices.Insert(Placement.TypeIndex, Index);
+    LaneIndices.Insert(Placement.LaneIndex, Index);
+    Flags.Insert(Placement.bSpawnPlane ? SpawnPlaneFlag : 0, Index);
+    Sources.Insert(Source, Index);
+}
+
+int32 FObstacleEntityStore::NumUpTo(float MaxY) const
+{
+    return Algo::UpperBound(Y, MaxY);
+}
+
+FObstaclePlacement FObstacleEntityStore::GetPlacement(int32 Index) const
+{
+    FObstaclePlacement Placement;
+    Placement.Y = Y[Index];
+    Placement.GroundOffsetZ = GroundOffsetZ[Index];
+    Placement.TypeIndex = TypeIndices[Index];
+    Placement.LaneIndex = LaneIndices[Index];
+    Placement.bSpawnPlane = (Flags[Index] & SpawnPlaneFlag) != 0;
+    return Placement;
+}
+
+void FObstacleEntityStore::RemoveFront(int32 Count)
+{
+    if (Count <= 0)
+    {
+        return;
+    }
+
+    // Keep the allocations, the store fills up again with the next chunk
+    Y.RemoveAt(0, Count, false);
+    GroundOffsetZ.RemoveAt(0, Count, false);
+    TypeIndices.RemoveAt(0, Count, false);
+    LaneIndices.RemoveAt(0, Count, false);
+    Flags.RemoveAt(0, Count, false);
+    Sources.RemoveAt(0, Count, false);
+}
+
+int32 FObstacleEntityStore::RemoveSource(int32 Source)
+{
+    // One compacting pass over every fragment array, which keeps the Y order
+    int32 NumKept = 0;
+    for (int32 Index = 0; Index < Sources.Num(); ++Index)
+    {
+        if (Sources[Index] == Source)
+        {
+            continue;
+        }
+        if (NumKept != Index)
+        {
+            Y[NumKept] = Y[Index];
+            GroundOffsetZ[NumKept] = GroundOffsetZ[Index];
+            TypeIndices[NumKept] = TypeIndices[Index];
+            LaneIndices[NumKept] = LaneIndices[Index];
+            Flags[NumKept] = Flags[Index];
+            Sources[NumKept] = Sources[Index];
+        }
+        ++NumKept;
+    }
+
+    const int32 NumRemoved = Sources.Num() - NumKept;
+    Y.SetNum(NumKept, false);
+    GroundOffsetZ.SetNum(NumKept, false);
+    TypeIndices.SetNum(NumKept, false);
+    LaneIndices.SetNum(NumKept, false);
+    Flags.SetNum(NumKept, false);
+    Sources.SetNum(NumKept, false);
+    return NumRemoved;
+}
+
+void FObstacleEntityStore::ShiftAll(float DeltaY)
+{
+    for (float& EntityY : Y)
+    {
+        EntityY += DeltaY;
+    }
+}
+
+void FObstacleEntityStore::Reset()
+{
+    Y.Reset();
+    GroundOffsetZ.Reset();
+    TypeIndices.Reset();
+    LaneIndices.Reset();
+    Flags.Reset();
+    Sources.Reset();
+}
@@ -0,0 +1,64 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleFootprintCache.h"
+#include "ObstacleSpawner.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/StaticMesh.h"
+
+FBox FObstacleFootprintCache::GetLocalBounds(UObject* Asset)
+{
+    if (!Asset)
+    {
+        return FBox(ForceInit);
+    }
+
+    if (const FBox* Cached = Bounds.Find(Asset))
+    {
+        return *Cached;
+    }
+
+    FBox LocalBounds(ForceInit);
+    if (const UStaticMesh* StaticMesh = Cast<UStaticMesh>(Asset))
+    {
+        LocalBounds = StaticMesh->GetBounds().GetBox();
+    }
+    else if (const USkeletalMesh* SkeletalMesh = Cast<USkeletalMesh>(Asset))
+    {
+        LocalBounds = SkeletalMesh->GetBounds().GetBox();
+    }
+    else if (UClass* ActorClass = Cast<UClass>(Asset))
+    {
+        LocalBounds = AActor::GetActorClassDefaultComponentsBoundingBox(ActorClass);
+    }
+    return Bounds.Add(Asset, LocalBounds);
+}
+
+FBox FObstacleFootprintCache::GetFootprint(const FObstacleSpawnInfo& SpawnInfo)
+{
+    // The same combination SpawnPlacement spawns: the static mesh, plus the actor class or else the skeletal mesh
+    FBox LocalBounds = GetLocalBounds(SpawnInfo.GetStaticMesh());
+    if (SpawnInfo.HasObstacleActorClass())
+    {
+        LocalBounds += GetLocalBounds(SpawnInfo.GetObstacleActorClass());
+    }
+    else
+    {
+        LocalBounds += GetLocalBounds(SpawnInfo.GetSkeletalMesh());
+    }
+
+    if (!LocalBounds.IsValid)
+    {
+        return LocalBounds;
+    }
+    return LocalBounds.TransformBy(FTransform(SpawnInfo.Rotation, SpawnInfo.LocationOffset, SpawnInfo.Scale));
+}
+
+void FObstacleFootprintCache::GetFootprints(const TArray<FObstacleSpawnInfo>& ObstacleTypes, TArray<FBox>& OutFootprints)
+{
+    OutFootprints.Reset(ObstacleTypes.Num());
+    for (const FObstacleSpawnInfo& SpawnInfo : ObstacleTypes)
+    {
+        OutFootprints.Add(GetFootprint(SpawnInfo));
+    }
+}
@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleInstanceBatcher.h"
+#include "ObstacleSpawnerStats.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+
+int32 FObstacleInstanceBatcher::AddInstance(AActor* Owner, UStaticMesh* Mesh, const FTransform& Transform)
+{
+    FObstacleInstanceBatch& Batch = Batches.FindOrAdd(Mesh);
+    if (!IsValid(Batch.Component))
+    {
+        // Plain ISM rather than HISM: instances change every few frames and HISM would rebuild its cluster tree each time
+        Batch.Component = NewObject<UInstancedStaticMeshComponent>(Owner);
+        Batch.Component->SetMobility(EComponentMobility::Movable);
+        Batch.Component->SetStaticMesh(Mesh);
+        Batch.Component->RegisterComponent();
+        Batch.FreeInstances.Reset();
+        INC_DWORD_STAT(STAT_ObstacleInstanceBatches);
+    }
+
+    ++NumLiveInstances;
+    INC_DWORD_STAT(STAT_InstancedObstacles);
+
+    if (Batch.FreeInstances.Num() > 0)
+    {
+        // A non-zero scale gives the instance its collision body back
+        const int32 InstanceIndex = Batch.FreeInstances.Pop(false);
+        Batch.Component->UpdateInstanceTransform(InstanceIndex, Transform, true, true, true);
+        return InstanceIndex;
+    }
+    return Batch.Component->AddInstance(Transform, true);
+}
+
+void FObstacleInstanceBatcher::RemoveInstance(UStaticMesh* Mesh, int32 InstanceIndex)
+{
+    FObstacleInstanceBatch* Batch = Batches.Find(Mesh);
+    if (!Batch || !IsValid(Batch->Component) || !Batch->Component->IsValidInstance(InstanceIndex))
+    {
+        return;
+    }
+
+    // Zero scale culls the instance and makes the component drop its physics body
+    FTransform ParkedTransform;
+    Batch->Component->GetInstanceTransform(InstanceIndex, ParkedTransform, true);
+    ParkedTransform.SetScale3D(FVector::ZeroVector);
+    Batch->Component->UpdateInstanceTransform(InstanceIndex, ParkedTransform, true, true, true);
+    Batch->FreeInstances.Add(InstanceIndex);
+
+    --NumLiveInstances;
+    DEC_DWORD_STAT(STAT_InstancedObstacles);
+}
+
+void FObstacleInstanceBatcher::DropIdleBatch(UStaticMesh* Mesh)
+{
+    FObstacleInstanceBatch* Batch = Batches.Find(Mesh);
+    if (!Batch)
+    {
+        return;
+    }
+
+    if (IsValid(Batch->Component))
+    {
+        // Every instance still showing belongs to a live obstacle, the batch goes with the last of them
+        if (Batch->Component->GetInstanceCount() > Batch->FreeInstances.Num())
+        {
+            return;
+        }
+        Batch->Component->DestroyComponent();
+    }
+    Batches.Remove(Mesh);
+    DEC_DWORD_STAT(STAT_ObstacleInstanceBatches);
+}
+
+bool FObstacleInstanceBatcher::GetInstanceTransform(UStaticMesh* Mesh, int32 InstanceIndex, FTransform& OutTransform) const
+{
+    const FObstacleInstanceBatch* Batch = Batches.Find(Mesh);
+    return Batch && IsValid(Batch->Component) && Batch->Component->GetInstanceTransform(InstanceIndex, OutTransform, true);
+}
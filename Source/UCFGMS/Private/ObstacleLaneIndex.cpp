@@ -0,0 +1,220 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleLaneIndex.h"
+#include "Algo/BinarySearch.h"
+
+int32 FObstacleLaneIndex::Add(const FLaneObstacle& Obstacle)
+{
+    check(Obstacle.Lane >= 0);
+    if (Obstacle.Lane >= Lanes.Num())
+    {
+        Lanes.SetNum(Obstacle.Lane + 1);
+    }
+
+    FLocation Location;
+    Location.Lane = Obstacle.Lane;
+    Location.MinY = Obstacle.MinY;
+    const int32 Id = Locations.Add(Location);
+
+    // Obstacles mostly arrive in track order, so this is nearly always an append
+    FLaneEntries& Entries = Lanes[Obstacle.Lane];
+    const int32 InsertIndex = Algo::UpperBoundBy(Entries.Obstacles, Obstacle.MinY, &FLaneObstacle::MinY);
+    FLaneObstacle& Entry = Entries.Obstacles.Insert_GetRef(Obstacle, InsertIndex);
+    Entry.Id = Id;
+    AddLength(Entries, Obstacle.MaxY - Obstacle.MinY);
+    return Id;
+}
+
+void FObstacleLaneIndex::Remove(int32 Id)
+{
+    if (!Locations.IsValidIndex(Id))
+    {
+        return;
+    }
+
+    const FLocation& Location = Locations[Id];
+    const int32 EntryIndex = FindEntryIndex(Location, Id);
+    if (EntryIndex != INDEX_NONE)
+    {
+        RemoveEntry(Lanes[Location.Lane], EntryIndex);
+    }
+    Locations.RemoveAt(Id);
+}
+
+void FObstacleLaneIndex::Move(int32 Id, float MinY, float MaxY)
+{
+    if (!Locations.IsValidIndex(Id))
+    {
+        return;
+    }
+
+    FLocation& Location = Locations[Id];
+    FLaneEntries& Entries = Lanes[Location.Lane];
+    const int32 EntryIndex = FindEntryIndex(Location, Id);
+    if (EntryIndex == INDEX_NONE)
+    {
+        return;
+    }
+
+    TArray<FLaneObstacle>& Obstacles = Entries.Obstacles;
+    FLaneObstacle Obstacle = Obstacles[EntryIndex];
+    const float OldLength = Obstacle.MaxY - Obstacle.MinY;
+    Obstacle.MinY = MinY;
+    Obstacle.MaxY = MaxY;
+    Location.MinY = MinY;
+
+    // Usually it stays in order with its neighbours and is updated in place, otherwise only the entries it
+    // passed are shifted over
+    if (EntryIndex > 0 && MinY < Obstacles[EntryIndex - 1].MinY)
+    {
+        const int32 NewIndex = Algo::UpperBoundBy(MakeArrayView(Obstacles.GetData(), EntryIndex), MinY, &FLaneObstacle::MinY);
+        for (int32 Index = EntryIndex; Index > NewIndex; --Index)
+        {
+            Obstacles[Index] = Obstacles[Index - 1];
+        }
+        Obstacles[NewIndex] = Obstacle;
+    }
+    else if (EntryIndex + 1 < Obstacles.Num() && MinY > Obstacles[EntryIndex + 1].MinY)
+    {
+        const int32 FirstAfter = EntryIndex + 1;
+        const int32 NewIndex = FirstAfter + Algo::UpperBoundBy(MakeArrayView(Obstacles.GetData() + FirstAfter, Obstacles.Num() - FirstAfter), MinY, &FLaneObstacle::MinY) - 1;
+        for (int32 Index = EntryIndex; Index < NewIndex; ++Index)
+        {
+            Obstacles[Index] = Obstacles[Index + 1];
+        }
+        Obstacles[NewIndex] = Obstacle;
+    }
+    else
+    {
+        Obstacles[EntryIndex] = Obstacle;
+    }
+
+    // The new length is counted first, so a rescan for the old one already sees it
+    AddLength(Entries, MaxY - MinY);
+    RemoveLength(Entries, OldLength);
+}
+
+void FObstacleLaneIndex::ShiftAll(float DeltaY)
+{
+    for (FLaneEntries& Entries : Lanes)
+    {
+        // Shifting can round the lengths, so the longest is counted again from the shifted entries
+        Entries.MaxLength = 0.0f;
+        Entries.NumAtMaxLength = 0;
+        for (FLaneObstacle& Obstacle : Entries.Obstacles)
+        {
+            Obstacle.MinY += DeltaY;
+            Obstacle.MaxY += DeltaY;
+            if (Obstacle.Id != INDEX_NONE)
+            {
+                AddLength(Entries, Obstacle.MaxY - Obstacle.MinY);
+            }
+        }
+    }
+
+    // Shifted exactly like the entries, so an id still finds its entry by MinY
+    for (FLocation& Location : Locations)
+    {
+        Location.MinY += DeltaY;
+    }
+}
+
+const FLaneObstacle* FObstacleLaneIndex::FindNext(int32 Lane, float Y) const
+{
+    if (!Lanes.IsValidIndex(Lane))
+    {
+        return nullptr;
+    }
+
+    const TArray<FLaneObstacle>& Obstacles = Lanes[Lane].Obstacles;
+    for (int32 Index = Algo::UpperBoundBy(Obstacles, Y, &FLaneObstacle::MinY); Index < Obstacles.Num(); ++Index)
+    {
+        if (Obstacles[Index].Id != INDEX_NONE)
+        {
+            return &Obstacles[Index];
+        }
+    }
+    return nullptr;
+}
+
+void FObstacleLaneIndex::FindInRange(int32 Lane, float MinY, float MaxY, TArray<FLaneObstacle>& OutObstacles) const
+{
+    if (!Lanes.IsValidIndex(Lane))
+    {
+        return;
+    }
+
+    const FLaneEntries& Entries = Lanes[Lane];
+    const int32 StartIndex = Algo::LowerBoundBy(Entries.Obstacles, MinY - Entries.MaxLength, &FLaneObstacle::MinY);
+    for (int32 Index = StartIndex; Index < Entries.Obstacles.Num() && Entries.Obstacles[Index].MinY <= MaxY; ++Index)
+    {
+        const FLaneObstacle& Obstacle = Entries.Obstacles[Index];
+        if (Obstacle.Id != INDEX_NONE && Obstacle.MaxY >= MinY)
+        {
+            OutObstacles.Add(Obstacle);
+        }
+    }
+}
+
+int32 FObstacleLaneIndex::FindEntryIndex(const FLocation& Location, int32 Id) const
+{
+    const TArray<FLaneObstacle>& Obstacles = Lanes[Location.Lane].Obstacles;
+    for (int32 Index = Algo::LowerBoundBy(Obstacles, Location.MinY, &FLaneObstacle::MinY); Index < Obstacles.Num() && Obstacles[Index].MinY == Location.MinY; ++Index)
+    {
+        if (Obstacles[Index].Id == Id)
+        {
+            return Index;
+        }
+    }
+    return INDEX_NONE;
+}
+
+void FObstacleLaneIndex::AddLength(FLaneEntries& Entries, float Length)
+{
+    if (Length > Entries.MaxLength)
+    {
+        Entries.MaxLength = Length;
+        Entries.NumAtMaxLength = 1;
+    }
+    else if (Length == Entries.MaxLength)
+    {
+        ++Entries.NumAtMaxLength;
+    }
+}
+
+void FObstacleLaneIndex::RemoveLength(FLaneEntries& Entries, float Length)
+{
+    if (Length < Entries.MaxLength || --Entries.NumAtMaxLength > 0)
+    {
+        return;
+    }
+
+    // The last of the longest obstacles went, the next longest is found among the live entries
+    Entries.MaxLength = 0.0f;
+    Entries.NumAtMaxLength = 0;
+    for (const FLaneObstacle& Obstacle : Entries.Obstacles)
+    {
+        if (Obstacle.Id != INDEX_NONE)
+        {
+            AddLength(Entries, Obstacle.MaxY - Obstacle.MinY);
+        }
+    }
+}
+
+void FObstacleLaneIndex::RemoveEntry(FLaneEntries& Entries, int32 EntryIndex)
+{
+    // Marked before the length goes, a rescan for the longest must not count it
+    FLaneObstacle& Obstacle = Entries.Obstacles[EntryIndex];
+    Obstacle.Id = INDEX_NONE;
+    Obstacle.Actor = nullptr;
+    Obstacle.Component = nullptr;
+    RemoveLength(Entries, Obstacle.MaxY - Obstacle.MinY);
+
+    // Compacting once half the lane is removed keeps removal amortized constant time
+    if (++Entries.NumRemoved * 2 > Entries.Obstacles.Num())
+    {
+        Entries.Obstacles.RemoveAll([](const FLaneObstacle& Entry) { return Entry.Id == INDEX_NONE; });
+        Entries.NumRemoved = 0;
+    }
+}
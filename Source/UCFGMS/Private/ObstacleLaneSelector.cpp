@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleLaneSelector.h"
+#include "ObstacleSpawnerStats.h"
+#include "HAL/IConsoleManager.h"
+
+void FObstacleLaneSelector::Reset(int32 NumLanes)
+{
+    NumLanes = FMath::Clamp(NumLanes, 0, MaxLanes);
+    Lanes.SetNumUninitialized(NumLanes, false);
+    for (int32 Lane = 0; Lane < NumLanes; ++Lane)
+    {
+        Lanes[Lane] = static_cast<uint8>(Lane);
+    }
+    NumLeastUsed = NumLanes;
+}
+
+#if !UE_BUILD_SHIPPING
+
+// The lane loop SpawnObstacles used before FObstacleLaneSelector, kept to compare against
+static int32 PickLeastSpawnedLaneByScan(TArray<int32>& LaneSpawnCount, FRandomStream& Random)
+{
+    int32 MinCount = LaneSpawnCount[0];
+    for (int32 i = 1; i < LaneSpawnCount.Num(); ++i)
+    {
+        if (LaneSpawnCount[i] < MinCount)
+            MinCount = LaneSpawnCount[i];
+    }
+
+    TArray<int32> LeastSpawnedLanes;
+    for (int32 i = 0; i < LaneSpawnCount.Num(); ++i)
+    {
+        if (LaneSpawnCount[i] == MinCount)
+            LeastSpawnedLanes.Add(i);
+    }
+
+    int32 LaneIndex = LeastSpawnedLanes[Random.RandRange(0, LeastSpawnedLanes.Num() - 1)];
+    LaneSpawnCount[LaneIndex]++;
+    return LaneIndex;
+}
+
+static void BenchmarkLaneSelector(const TArray<FString>& Args)
+{
+    const int32 NumPicks = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000000;
+    const int32 LaneCounts[] = { 3, 5, 7 };
+
+    for (const int32 NumLanes : LaneCounts)
+    {
+        // Summing the picks keeps the optimizer from dropping either loop
+        int64 Checksum = 0;
+
+        FRandomStream ScanRandom(NumLanes);
+        TArray<int32> LaneSpawnCount;
+        LaneSpawnCount.Init(0, NumLanes);
+        const double ScanStart = FPlatformTime::Seconds();
+        for (int32 Pick = 0; Pick < NumPicks; ++Pick)
+        {
+            Checksum += PickLeastSpawnedLaneByScan(LaneSpawnCount, ScanRandom);
+        }
+        const double ScanSeconds = FPlatformTime::Seconds() - ScanStart;
+
+        FRandomStream SelectorRandom(NumLanes);
+        FObstacleLaneSelector Selector;
+        Selector.Reset(NumLanes);
+        const double SelectorStart = FPlatformTime::Seconds();
+        for (int32 Pick = 0; Pick < NumPicks; ++Pick)
+        {
+            Checksum += Selector.Pick(SelectorRandom);
+        }
+        const double SelectorSeconds = FPlatformTime::Seconds() - SelectorStart;
+
+        UE_LOG(LogObstacleSpawner, Display, TEXT("%d lanes, %d picks: scan %.2f ns/pick, selector %.2f ns/pick (checksum %lld)"),
+            NumLanes, NumPicks, ScanSeconds * 1.0e9 / NumPicks, SelectorSeconds * 1.0e9 / NumPicks, Checksum);
+    }
+}
+
+static FAutoConsoleCommand BenchmarkLaneSelectorCommand(
+    TEXT("Obstacles.BenchmarkLaneSelector"),
+    TEXT("Times the least-used lane pick against the old per-obstacle scan for 3, 5 and 7 lanes. Optional argument: number of picks"),
+    FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkLaneSelector));
+
+#endif
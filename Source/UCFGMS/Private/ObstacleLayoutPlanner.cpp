@@ -0,0 +1,166 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleLayoutPlanner.h"
+#include "ObstacleAliasTable.h"
+#include "ObstacleLaneSelector.h"
+#include "ObstaclePatternLibrary.h"
+#include "ObstacleSpawner.h"
+#include "ObstacleSpawnerStats.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+void FObstacleLayoutPlanner::Compile(const FObstacleSpawnParameters& Parameters, const TArray<FBox>& Footprints)
+{
+    check(Footprints.Num() == Parameters.ObstacleTypes.Num());
+    NumObstacles = Parameters.NumObstacles;
+    SpacingBetweenObstacles = Parameters.SpacingBetweenObstacles;
+
+    Types.Reset(Parameters.ObstacleTypes.Num());
+    for (int32 TypeIndex = 0; TypeIndex < Parameters.ObstacleTypes.Num(); ++TypeIndex)
+    {
+        const FObstacleSpawnInfo& SpawnInfo = Parameters.ObstacleTypes[TypeIndex];
+        const FBox& Footprint = Footprints[TypeIndex];
+
+        FObstacleTypeLayout& Layout = Types.AddDefaulted_GetRef();
+        Layout.FootprintMinY = Footprint.IsValid ? Footprint.Min.Y : SpawnInfo.LocationOffset.Y;
+        Layout.FootprintMaxY = Footprint.IsValid ? Footprint.Max.Y : SpawnInfo.LocationOffset.Y + DefaultFootprintLength;
+        Layout.SpacingAfter = SpawnInfo.SpacingAfterindevisualObstacles;
+        Layout.bHasPlane = SpawnInfo.HasPlane();
+        Layout.PlaneSpawnProbability = SpawnInfo.PlaneSpawnProbability;
+    }
+
+    // Weighted type picks through an alias table, see BuildObstacleAliasTable
+    TArray<float, TInlineAllocator<32>> Weights;
+    for (const FObstacleSpawnInfo& SpawnInfo : Parameters.ObstacleTypes)
+    {
+        Weights.Add(SpawnInfo.SpawnWeight);
+    }
+    BuildObstacleAliasTable(MakeArrayView(Weights), AliasProbability, AliasTypes);
+
+    CompiledHash = HashLayout(Parameters, Footprints);
+    bCompiled = true;
+}
+
+void FObstacleLayoutPlanner::CompileIfChanged(const FObstacleSpawnParameters& Parameters, const TArray<FBox>& Footprints)
+{
+    if (!IsCompiledFor(Parameters, Footprints))
+    {
+        Compile(Parameters, Footprints);
+    }
+}
+
+bool FObstacleLayoutPlanner::IsCompiledFor(const FObstacleSpawnParameters& Parameters, const TArray<FBox>& Footprints) const
+{
+    return bCompiled && HashLayout(Parameters, Footprints) == CompiledHash;
+}
+
+uint32 FObstacleLayoutPlanner::HashLayout(const FObstacleSpawnParameters& Parameters, const TArray<FBox>& Footprints)
+{
+    uint32 Hash = HashCombine(GetTypeHash(Parameters.NumObstacles), GetTypeHash(Parameters.SpacingBetweenObstacles));
+    for (const FObstacleSpawnInfo& SpawnInfo : Parameters.ObstacleTypes)
+    {
+        Hash = HashCombine(Hash, GetTypeHash(SpawnInfo.SpawnWeight));
+        Hash = HashCombine(Hash, GetTypeHash(SpawnInfo.LocationOffset.Y));
+        Hash = HashCombine(Hash, GetTypeHash(SpawnInfo.SpacingAfterindevisualObstacles));
+        Hash = HashCombine(Hash, GetTypeHash(SpawnInfo.PlaneSpawnProbability));
+        Hash = HashCombine(Hash, GetTypeHash(SpawnInfo.HasPlane()));
+    }
+
+    // Footprints change once streamed assets arrive
+    for (const FBox& Footprint : Footprints)
+    {
+        Hash = HashCombine(Hash, GetTypeHash(Footprint.IsValid));
+        Hash = HashCombine(Hash, GetTypeHash(Footprint.Min.Y));
+        Hash = HashCombine(Hash, GetTypeHash(Footprint.Max.Y));
+    }
+    return HashCombine(Hash, GetTypeHash(Parameters.ObstacleTypes.Num()));
+}
+
+void FObstacleLayoutPlanner::SetPatterns(TSharedPtr<const FObstaclePatternLibrary, ESPMode::ThreadSafe> Library, float Probability)
+{
+    PatternLibrary = Library && Library->Num() > 0 ? MoveTemp(Library) : nullptr;
+    PatternProbability = FMath::Clamp(Probability, 0.0f, 1.0f);
+}
+
+int32 FObstacleLayoutPlanner::GetMaxPlacements() const
+{
+    return PatternLibrary ? NumObstacles * FMath::Max(1, PatternLibrary->GetMaxPatternObstacles()) : NumObstacles;
+}
+
+int32 FObstacleLayoutPlanner::PickType(FRandomStream& Random) const
+{
+    const int32 Column = Random.RandRange(0, Types.Num() - 1);
+    return Random.GetFraction() < AliasProbability[Column] ? Column : AliasTypes[Column];
+}
+
+float FObstacleLayoutPlanner::PlanInto(float StartY, int32 NumLanes, FRandomStream& Random, TArrayView<FObstaclePlacement> OutPlacements, int32& OutNumPlanned) const
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(FObstacleLayoutPlanner::Plan, ObstacleSpawnerChannel);
+
+    OutNumPlanned = 0;
+    if (Types.Num() == 0 || NumLanes <= 0)
+    {
+        return StartY;
+    }
+
+    FObstacleLaneSelector LaneSelector;
+    LaneSelector.Reset(NumLanes);
+    float CurrentYPosition = StartY; // Where the footprint of the next obstacle may start
+
+    for (int32 ObstacleIndex = 0; ObstacleIndex < NumObstacles; ++ObstacleIndex)
+    {
+        // Some slots take a whole hand-authored formation instead of a single obstacle
+        if (PatternLibrary && Random.GetFraction() < PatternProbability)
+        {
+            const FObstaclePatternRecord& Pattern = PatternLibrary->GetPattern(PatternLibrary->Pick(Random));
+            if (Pattern.NumLanes <= NumLanes)
+            {
+                for (const FObstaclePatternRecordObstacle& Obstacle : PatternLibrary->GetObstacles(Pattern))
+                {
+                    // Patterns are authored against one set of types, skip what this spawner does not have
+                    if (Obstacle.TypeIndex >= Types.Num())
+                    {
+                        continue;
+                    }
+
+                    FObstaclePlacement& Placement = OutPlacements[OutNumPlanned++];
+                    Placement = FObstaclePlacement();
+                    Placement.Y = CurrentYPosition + Obstacle.OffsetY;
+                    Placement.TypeIndex = Obstacle.TypeIndex;
+                    Placement.LaneIndex = Obstacle.Lane;
+                    Placement.bSpawnPlane = Types[Obstacle.TypeIndex].bHasPlane && (Obstacle.Flags & FObstaclePatternRecordObstacle::SpawnPlaneFlag) != 0;
+                }
+
+                UE_LOG(LogObstacleSpawner, VeryVerbose, TEXT("Planned a pattern of %d obstacles at Y %f"), Pattern.NumObstacles, CurrentYPosition);
+                CurrentYPosition += Pattern.Length + SpacingBetweenObstacles;
+                continue;
+            }
+        }
+
+        // Randomly choose a lane from those with the least spawns
+        const int32 LaneIndex = LaneSelector.Pick(Random);
+
+        const int32 ObstacleTypeIndex = PickType(Random);
+        const FObstacleTypeLayout& Type = Types[ObstacleTypeIndex];
+
+        // Spawn so the footprint starts at the cursor, long obstacles like trains then push the next one back by their length
+        const float SpawnY = CurrentYPosition - Type.FootprintMinY;
+
+        FObstaclePlacement& Placement = OutPlacements[OutNumPlanned++];
+        Placement = FObstaclePlacement();
+        Placement.Y = SpawnY;
+        Placement.TypeIndex = static_cast<uint16>(ObstacleTypeIndex);
+        Placement.LaneIndex = static_cast<uint8>(LaneIndex);
+
+        // Check if this is the train and if a plane should be spawned
+        if (Type.bHasPlane)
+        {
+            float RandomChance = Random.FRandRange(0.0f, 1.0f);
+            Placement.bSpawnPlane = RandomChance <= Type.PlaneSpawnProbability;
+        }
+
+        UE_LOG(LogObstacleSpawner, VeryVerbose, TEXT("Planned obstacle type %d in lane %d at Y %f"), ObstacleTypeIndex, LaneIndex, SpawnY);
+        CurrentYPosition = SpawnY + Type.FootprintMaxY + SpacingBetweenObstacles + Type.SpacingAfter;
+    }
+    return CurrentYPosition;
+}
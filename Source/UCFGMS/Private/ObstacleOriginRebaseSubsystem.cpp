@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleOriginRebaseSubsystem.h"
+#include "ObstacleSpawnerStats.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+void UObstacleOriginRebaseSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Super::Initialize(Collection);
+    WorldTickStartHandle = FWorldDelegates::OnWorldTickStart.AddUObject(this, &UObstacleOriginRebaseSubsystem::HandleWorldTickStart);
+    WorldOriginOffsetHandle = FWorldDelegates::OnPostWorldOriginOffset.AddUObject(this, &UObstacleOriginRebaseSubsystem::HandleWorldOriginOffset);
+}
+
+void UObstacleOriginRebaseSubsystem::Deinitialize()
+{
+    FWorldDelegates::OnWorldTickStart.Remove(WorldTickStartHandle);
+    FWorldDelegates::OnPostWorldOriginOffset.Remove(WorldOriginOffsetHandle);
+    bRebaseRequested = false;
+    Super::Deinitialize();
+}
+
+void UObstacleOriginRebaseSubsystem::RequestRebase(float Threshold)
+{
+    // Several requests in one frame end up as one shift
+    RequestedThreshold = bRebaseRequested ? FMath::Min(RequestedThreshold, Threshold) : Threshold;
+    bRebaseRequested = true;
+}
+
+bool UObstacleOriginRebaseSubsystem::RebaseOrigin(int32 DeltaY)
+{
+    UWorld* World = GetWorld();
+    if (!World || DeltaY == 0)
+    {
+        return false;
+    }
+
+    TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(UObstacleOriginRebaseSubsystem::RebaseOrigin, ObstacleSpawnerChannel);
+    SCOPE_CYCLE_COUNTER(STAT_RebaseWorldOrigin);
+
+    const FIntVector NewOrigin = World->OriginLocation + FIntVector(0, DeltaY, 0);
+    if (!World->SetNewWorldOrigin(NewOrigin))
+    {
+        UE_LOG(LogObstacleSpawner, Warning, TEXT("Could not move the world origin to %s"), *NewOrigin.ToString());
+        return false;
+    }
+
+    INC_DWORD_STAT(STAT_WorldOriginRebases);
+    CSV_CUSTOM_STAT(ObstacleSpawner, WorldOriginRebases, 1, ECsvCustomStatOp::Accumulate);
+    UE_LOG(LogObstacleSpawner, Log, TEXT("Moved the world origin by %d along the track, it is now at %s"), DeltaY, *NewOrigin.ToString());
+    return true;
+}
+
+void UObstacleOriginRebaseSubsystem::HandleWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds)
+{
+    if (InWorld != GetWorld() || !bRebaseRequested)
+    {
+        return;
+    }
+    bRebaseRequested = false;
+
+    // Nothing has ticked yet this frame, so no actor sees positions from both sides of the shift
+    const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(InWorld, 0);
+    if (!PlayerPawn)
+    {
+        return;
+    }
+
+    const double PlayerY = PlayerPawn->GetActorLocation().Y;
+    if (FMath::Abs(PlayerY) >= RequestedThreshold)
+    {
+        RebaseOrigin(FMath::RoundToInt32(PlayerY));
+    }
+}
+
+void UObstacleOriginRebaseSubsystem::HandleWorldOriginOffset(UWorld* InWorld, FIntVector SrcOrigin, FIntVector DstOrigin)
+{
+    // Also fires for shifts made by anyone else, Blueprint listeners have to follow those too
+    if (InWorld == GetWorld())
+    {
+        OnWorldOriginShifted.Broadcast(FVector(SrcOrigin - DstOrigin));
+    }
+}
+
+#if !UE_BUILD_SHIPPING
+
+// Shifts the origin right away and checks that nothing moved relative to the player, which is all the player can see
+static void RebaseOriginNow(const TArray<FString>& Args, UWorld* World)
+{
+    UObstacleOriginRebaseSubsystem* Rebase = World ? World->GetSubsystem<UObstacleOriginRebaseSubsystem>() : nullptr;
+    const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(World, 0);
+    if (!Rebase || !PlayerPawn)
+    {
+        UE_LOG(LogObstacleSpawner, Warning, TEXT("Obstacles.RebaseOrigin needs a game world with a player pawn"));
+        return;
+    }
+
+    const FVector PlayerBefore = PlayerPawn->GetActorLocation();
+    TArray<TPair<TWeakObjectPtr<AActor>, FVector>> RelativeBefore;
+    for (TActorIterator<AActor> It(World); It; ++It)
+    {
+        RelativeBefore.Emplace(*It, It->GetActorLocation() - PlayerBefore);
+    }
+
+    const int32 DeltaY = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : FMath::RoundToInt32(PlayerBefore.Y);
+    const double StartTime = FPlatformTime::Seconds();
+    if (!Rebase->RebaseOrigin(DeltaY))
+    {
+        return;
+    }
+    const double ShiftMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+
+    const FVector PlayerAfter = PlayerPawn->GetActorLocation();
+    double LargestJump = 0.0;
+    for (const TPair<TWeakObjectPtr<AActor>, FVector>& Entry : RelativeBefore)
+    {
+        if (const AActor* Actor = Entry.Key.Get())
+        {
+            LargestJump = FMath::Max(LargestJump, FVector::Dist(Actor->GetActorLocation() - PlayerAfter, Entry.Value));
+        }
+    }
+
+    UE_LOG(LogObstacleSpawner, Display, TEXT("Shifted %d actors by %d in %.3f ms, player Y %.1f -> %.1f, largest change relative to the player %.4f"),
+        RelativeBefore.Num(), DeltaY, ShiftMs, PlayerBefore.Y, PlayerAfter.Y, LargestJump);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs RebaseOriginCommand(
+    TEXT("Obstacles.RebaseOrigin"),
+    TEXT("Moves the world origin under the player now and logs how long the shift took and how far anything moved relative to the player. Optional argument: distance along the track"),
+    FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RebaseOriginNow));
+
+#endif
@@ -0,0 +1,187 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstaclePatternLibrary.h"
+#include "ObstacleAliasTable.h"
+#include "ObstacleSpawnerStats.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/FileHelper.h"
+
+static_assert(PLATFORM_LITTLE_ENDIAN, "Pattern files are read in place and stored little-endian");
+
+namespace
+{
+    template <typename ElementType>
+    void AppendRaw(TArray<uint8>& Bytes, const ElementType* Elements, int32 Num)
+    {
+        Bytes.Append(reinterpret_cast<const uint8*>(Elements), Num * sizeof(ElementType));
+    }
+}
+
+FObstaclePatternLibrary::~FObstaclePatternLibrary()
+{
+    // The region has to go before the file it maps
+    MappedRegion.Reset();
+    MappedFile.Reset();
+}
+
+TSharedPtr<const FObstaclePatternLibrary, ESPMode::ThreadSafe> FObstaclePatternLibrary::Load(const FString& Filename)
+{
+    TSharedRef<FObstaclePatternLibrary, ESPMode::ThreadSafe> Library = MakeShared<FObstaclePatternLibrary, ESPMode::ThreadSafe>();
+
+    // Packaged files inside a compressed pak cannot be mapped, those are read in one go instead
+    Library->MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+    if (Library->MappedFile)
+    {
+        Library->MappedRegion.Reset(Library->MappedFile->MapRegion(0, Library->MappedFile->GetFileSize()));
+    }
+
+    bool bBound = false;
+    if (Library->MappedRegion)
+    {
+        bBound = Library->Bind(Library->MappedRegion->GetMappedPtr(), Library->MappedRegion->GetMappedSize(), Filename);
+    }
+    else if (FFileHelper::LoadFileToArray(Library->FileData, *Filename))
+    {
+        bBound = Library->Bind(Library->FileData.GetData(), Library->FileData.Num(), Filename);
+    }
+    else
+    {
+        UE_LOG(LogObstacleSpawner, Warning, TEXT("Could not open obstacle pattern file %s"), *Filename);
+    }
+
+    if (!bBound)
+    {
+        return nullptr;
+    }
+
+    UE_LOG(LogObstacleSpawner, Log, TEXT("Loaded %d obstacle patterns from %s (%s)"), Library->Num(), *Filename, Library->MappedRegion ? TEXT("mapped") : TEXT("read"));
+    return Library;
+}
+
+bool FObstaclePatternLibrary::Bind(const uint8* Data, int64 Size, const FString& Filename)
+{
+    FObstaclePatternFileHeader Header;
+    if (Size < static_cast<int64>(sizeof(Header)))
+    {
+        UE_LOG(LogObstacleSpawner, Warning, TEXT("%s is too short to be an obstacle pattern file"), *Filename);
+        return false;
+    }
+    FMemory::Memcpy(&Header, Data, sizeof(Header));
+
+    if (Header.Magic != FObstaclePatternFileHeader::ExpectedMagic)
+    {
+        UE_LOG(LogObstacleSpawner, Warning, TEXT("%s is not an obstacle pattern file"), *Filename);
+        return false;
+    }
+    if (Header.Version != FObstaclePatternFileHeader::CurrentVersion)
+    {
+        UE_LOG(LogObstacleSpawner, Warning, TEXT("%s is pattern file version %u, this build reads version %u, export it again"), *Filename, Header.Version, FObstaclePatternFileHeader::CurrentVersion);
+        return false;
+    }
+
+    // 64-bit sums, so huge counts in a damaged header cannot wrap around the size check
+    const int64 PatternsOffset = sizeof(Header);
+    const int64 ProbabilityOffset = PatternsOffset + int64(Header.NumPatterns) * sizeof(FObstaclePatternRecord);
+    const int64 AliasOffset = ProbabilityOffset + int64(Header.NumPatterns) * sizeof(float);
+    const int64 ObstaclesOffset = AliasOffset + int64(Header.NumPatterns) * sizeof(uint32);
+    const int64 ExpectedSize = ObstaclesOffset + int64(Header.NumObstacles) * sizeof(FObstaclePatternRecordObstacle);
+    if (Size < ExpectedSize || Header.NumPatterns > MAX_int32 || Header.NumObstacles > MAX_int32)
+    {
+        UE_LOG(LogObstacleSpawner, Warning, TEXT("%s is truncated, %lld bytes instead of %lld"), *Filename, Size, ExpectedSize);
+        return false;
+    }
+
+    const int32 NumPatterns = static_cast<int32>(Header.NumPatterns);
+    Patterns = MakeArrayView(reinterpret_cast<const FObstaclePatternRecord*>(Data + PatternsOffset), NumPatterns);
+    AliasProbability = MakeArrayView(reinterpret_cast<const float*>(Data + ProbabilityOffset), NumPatterns);
+    AliasPatterns = MakeArrayView(reinterpret_cast<const uint32*>(Data + AliasOffset), NumPatterns);
+    Obstacles = MakeArrayView(reinterpret_cast<const FObstaclePatternRecordObstacle*>(Data + ObstaclesOffset), static_cast<int32>(Header.NumObstacles));
+
+    // Planners size their output by MaxPatternObstacles and place obstacles by lane without further checks,
+    // so every record is checked once here and the maximum comes from the records rather than the header
+    MaxPatternObstacles = 0;
+    for (int32 PatternIndex = 0; PatternIndex < NumPatterns; ++PatternIndex)
+    {
+        const FObstaclePatternRecord& Pattern = Patterns[PatternIndex];
+        if (int64(Pattern.FirstObstacle) + Pattern.NumObstacles > int64(Header.NumObstacles))
+        {
+            UE_LOG(LogObstacleSpawner, Warning, TEXT("%s is damaged, pattern %d uses obstacles %u to %u of %u"), *Filename, PatternIndex, Pattern.FirstObstacle, Pattern.FirstObstacle + Pattern.NumObstacles, Header.NumObstacles);
+            return false;
+        }
+        for (const FObstaclePatternRecordObstacle& Obstacle : GetObstacles(Pattern))
+        {
+            if (Obstacle.Lane >= Pattern.NumLanes)
+            {
+                UE_LOG(LogObstacleSpawner, Warning, TEXT("%s is damaged, pattern %d has an obstacle in lane %d of %d"), *Filename, PatternIndex, Obstacle.Lane, Pattern.NumLanes);
+                return false;
+            }
+        }
+        MaxPatternObstacles = FMath::Max<int32>(MaxPatternObstacles, Pattern.NumObstacles);
+    }
+    if (Header.MaxPatternObstacles != static_cast<uint32>(MaxPatternObstacles))
+    {
+        UE_LOG(LogObstacleSpawner, Warning, TEXT("%s claims at most %u obstacles per pattern but has %d, using %d"), *Filename, Header.MaxPatternObstacles, MaxPatternObstacles, MaxPatternObstacles);
+    }
+    return true;
+}
+
+bool FObstaclePatternLibrary::Write(const TArray<FObstaclePattern>& InPatterns, TArray<uint8>& OutBytes)
+{
+    FObstaclePatternFileHeader Header;
+    TArray<FObstaclePatternRecord> Records;
+    TArray<FObstaclePatternRecordObstacle> RecordObstacles;
+    TArray<float> Weights;
+    Records.Reserve(InPatterns.Num());
+    Weights.Reserve(InPatterns.Num());
+
+    for (const FObstaclePattern& Pattern : InPatterns)
+    {
+        if (Pattern.Obstacles.Num() > MAX_uint16)
+        {
+            UE_LOG(LogObstacleSpawner, Error, TEXT("Obstacle pattern %s has more than %d obstacles"), *Pattern.Name.ToString(), MAX_uint16);
+            return false;
+        }
+
+        FObstaclePatternRecord& Record = Records.AddDefaulted_GetRef();
+        Record.FirstObstacle = RecordObstacles.Num();
+        Record.NumObstacles = static_cast<uint16>(Pattern.Obstacles.Num());
+        Record.Length = Pattern.Length;
+        Weights.Add(Pattern.Weight);
+
+        int32 NumLanes = 0;
+        for (const FObstaclePatternObstacle& Obstacle : Pattern.Obstacles)
+        {
+            if (Obstacle.TypeIndex < 0 || Obstacle.TypeIndex > MAX_uint16 || Obstacle.Lane < 0 || Obstacle.Lane >= MAX_uint8)
+            {
+                UE_LOG(LogObstacleSpawner, Error, TEXT("Obstacle pattern %s has an obstacle with type %d in lane %d, out of range"), *Pattern.Name.ToString(), Obstacle.TypeIndex, Obstacle.Lane);
+                return false;
+            }
+
+            FObstaclePatternRecordObstacle& RecordObstacle = RecordObstacles.AddDefaulted_GetRef();
+            RecordObstacle.OffsetY = Obstacle.OffsetY;
+            RecordObstacle.TypeIndex = static_cast<uint16>(Obstacle.TypeIndex);
+            RecordObstacle.Lane = static_cast<uint8>(Obstacle.Lane);
+            RecordObstacle.Flags = Obstacle.bSpawnPlane ? FObstaclePatternRecordObstacle::SpawnPlaneFlag : 0;
+            NumLanes = FMath::Max(NumLanes, Obstacle.Lane + 1);
+        }
+        Record.NumLanes = static_cast<uint8>(NumLanes);
+        Header.MaxPatternObstacles = FMath::Max<uint32>(Header.MaxPatternObstacles, Record.NumObstacles);
+    }
+
+    TArray<float> AliasProbability;
+    TArray<uint32> AliasPatterns;
+    BuildObstacleAliasTable(MakeArrayView(Weights), AliasProbability, AliasPatterns);
+
+    Header.NumPatterns = Records.Num();
+    Header.NumObstacles = RecordObstacles.Num();
+
+    OutBytes.Reset();
+    AppendRaw(OutBytes, &Header, 1);
+    AppendRaw(OutBytes, Records.GetData(), Records.Num());
+    AppendRaw(OutBytes, AliasProbability.GetData(), AliasProbability.Num());
+    AppendRaw(OutBytes, AliasPatterns.GetData(), AliasPatterns.Num());
+    AppendRaw(OutBytes, RecordObstacles.GetData(), RecordObstacles.Num());
+    return true;
+}
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstaclePatternSet.h"
+#include "ObstacleSpawnerStats.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_EDITOR
+void UObstaclePatternSet::ExportPatterns()
+{
+    TArray<uint8> Bytes;
+    if (!FObstaclePatternLibrary::Write(Patterns, Bytes))
+    {
+        return;
+    }
+
+    const FString Filename = FPaths::ProjectContentDir() / ExportFile;
+    if (!FFileHelper::SaveArrayToFile(Bytes, *Filename))
+    {
+        UE_LOG(LogObstacleSpawner, Error, TEXT("Could not write obstacle patterns to %s"), *Filename);
+        return;
+    }
+    UE_LOG(LogObstacleSpawner, Log, TEXT("Exported %d obstacle patterns to %s (%d bytes)"), Patterns.Num(), *Filename, Bytes.Num());
+}
+#endif
@@ -0,0 +1,222 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstaclePoolSubsystem.h"
+#include "ObstacleSpawnerStats.h"
+#include "PooledObstacle.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+
+void UObstaclePoolSubsystem::Deinitialize()
+{
+    // The world owns the actors, we only drop our references
+    Pools.Empty();
+    ParkedActors.Empty();
+    SET_DWORD_STAT(STAT_PooledActorsParked, 0);
+    SET_DWORD_STAT(STAT_PooledActorsInUse, 0);
+    Super::Deinitialize();
+}
+
+void UObstaclePoolSubsystem::Prewarm(TSubclassOf<AActor> ActorClass, int32 Count)
+{
+    if (!ActorClass || Count <= 0)
+    {
+        return;
+    }
+
+    FObstacleActorPool& Pool = FindOrAddPool(ActorClass.Get());
+    Pool.Parked.Reserve(Count);
+    while (Pool.Parked.Num() < Count)
+    {
+        AActor* Actor = SpawnPooledActor(ActorClass.Get(), FTransform::Identity);
+        if (!Actor)
+        {
+            break;
+        }
+        ParkActor(Actor);
+        Pool.Parked.Add(Actor);
+        ParkedActors.Add(Actor);
+        INC_DWORD_STAT(STAT_PooledActorsParked);
+    }
+}
+
+FObstacleActorPool& UObstaclePoolSubsystem::FindOrAddPool(UClass* ActorClass)
+{
+    if (FObstacleActorPool* Pool = Pools.Find(ActorClass))
+    {
+        return *Pool;
+    }
+
+    FObstacleActorPool& Pool = Pools.Add(ActorClass);
+    Pool.bClassEnablesCollision = ActorClass->GetDefaultObject<AActor>()->GetActorEnableCollision();
+    return Pool;
+}
+
+AActor* UObstaclePoolSubsystem::Acquire(TSubclassOf<AActor> ActorClass, const FTransform& Transform, bool bEnableCollision)
+{
+    bool bNeedsFinishSpawning = false;
+    bool bClassEnablesCollision = false;
+    return AcquireInternal(ActorClass.Get(), Transform, bEnableCollision, false, bNeedsFinishSpawning, bClassEnablesCollision);
+}
+
+AActor* UObstaclePoolSubsystem::AcquireDeferred(TSubclassOf<AActor> ActorClass, const FTransform& Transform, bool& bOutNeedsFinishSpawning, bool& bOutEnableCollision)
+{
+    return AcquireInternal(ActorClass.Get(), Transform, false, true, bOutNeedsFinishSpawning, bOutEnableCollision);
+}
+
+AActor* UObstaclePoolSubsystem::AcquireInternal(UClass* ActorClass, const FTransform& Transform, bool bEnableCollision, bool bDeferSpawn, bool& bOutNeedsFinishSpawning, bool& bOutEnableCollision)
+{
+    bOutNeedsFinishSpawning = false;
+    bOutEnableCollision = false;
+    if (!ActorClass)
+    {
+        return nullptr;
+    }
+
+    FObstacleActorPool& Pool = FindOrAddPool(ActorClass);
+    bOutEnableCollision = Pool.bClassEnablesCollision;
+
+    AActor* Actor = nullptr;
+    while (!Actor && Pool.Parked.Num() > 0)
+    {
+        // Parked actors can still be destroyed from outside (level unload, Blueprint), skip those
+        Actor = Pool.Parked.Pop(false);
+        ParkedActors.Remove(Actor);
+        DEC_DWORD_STAT(STAT_PooledActorsParked);
+        if (!IsValid(Actor))
+        {
+            Actor = nullptr;
+        }
+    }
+
+    if (Actor)
+    {
+        ++Pool.Stats.Hits;
+        ActivateActor(Actor, Transform, bEnableCollision && Pool.bClassEnablesCollision);
+    }
+    else
+    {
+        ++Pool.Stats.Misses;
+        Actor = SpawnPooledActor(ActorClass, Transform, bDeferSpawn);
+        if (!Actor)
+        {
+            return nullptr;
+        }
+        // A deferred actor has not run construction or BeginPlay yet, that happens when the caller finishes it
+        bOutNeedsFinishSpawning = bDeferSpawn;
+        if (!bEnableCollision)
+        {
+            Actor->SetActorEnableCollision(false);
+        }
+    }
+
+    ++Pool.Stats.InUse;
+    INC_DWORD_STAT(STAT_PooledActorsInUse);
+    Pool.Stats.HighWaterMark = FMath::Max(Pool.Stats.HighWaterMark, Pool.Stats.InUse);
+    return Actor;
+}
+
+void UObstaclePoolSubsystem::Release(AActor* Actor)
+{
+    if (!IsValid(Actor))
+    {
+        return;
+    }
+
+    bool bAlreadyParked = false;
+    ParkedActors.Add(Actor, &bAlreadyParked);
+    if (bAlreadyParked)
+    {
+        return;
+    }
+
+    FObstacleActorPool& Pool = FindOrAddPool(Actor->GetClass());
+    ParkActor(Actor);
+    Pool.Parked.Add(Actor);
+    Pool.Stats.InUse = FMath::Max(Pool.Stats.InUse - 1, 0);
+    INC_DWORD_STAT(STAT_PooledActorsParked);
+    DEC_DWORD_STAT(STAT_PooledActorsInUse);
+}
+
+void UObstaclePoolSubsystem::DropParked(TSubclassOf<AActor> ActorClass)
+{
+    FObstacleActorPool* Pool = Pools.Find(ActorClass.Get());
+    if (!Pool)
+    {
+        return;
+    }
+
+    for (AActor* Actor : Pool->Parked)
+    {
+        ParkedActors.Remove(Actor);
+        if (IsValid(Actor))
+        {
+            Actor->Destroy();
+        }
+    }
+    DEC_DWORD_STAT_BY(STAT_PooledActorsParked, Pool->Parked.Num());
+    Pool->Parked.Empty();
+
+    // Actors in use come back through Release, which adds the pool again
+    if (Pool->Stats.InUse == 0)
+    {
+        Pools.Remove(ActorClass.Get());
+    }
+}
+
+FObstaclePoolStats UObstaclePoolSubsystem::GetPoolStats(TSubclassOf<AActor> ActorClass) const
+{
+    const FObstacleActorPool* Pool = Pools.Find(ActorClass.Get());
+    return Pool ? Pool->Stats : FObstaclePoolStats();
+}
+
+void UObstaclePoolSubsystem::LogPoolStats() const
+{
+    for (const TPair<TObjectPtr<UClass>, FObstacleActorPool>& Pair : Pools)
+    {
+        const FObstaclePoolStats& Stats = Pair.Value.Stats;
+        UE_LOG(LogObstacleSpawner, Log, TEXT("Obstacle pool %s: Hits %d, Misses %d, InUse %d, Parked %d, HighWaterMark %d"),
+            *GetNameSafe(Pair.Key), Stats.Hits, Stats.Misses, Stats.InUse, Pair.Value.Parked.Num(), Stats.HighWaterMark);
+    }
+}
+
+AActor* UObstaclePoolSubsystem::SpawnPooledActor(UClass* ActorClass, const FTransform& Transform, bool bDeferSpawn) const
+{
+    UWorld* World = GetWorld();
+    if (!World)
+    {
+        return nullptr;
+    }
+
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+    SpawnParams.bDeferConstruction = bDeferSpawn;
+    return World->SpawnActor<AActor>(ActorClass, Transform, SpawnParams);
+}
+
+void UObstaclePoolSubsystem::ParkActor(AActor* Actor)
+{
+    Actor->SetActorHiddenInGame(true);
+    Actor->SetActorEnableCollision(false);
+    Actor->SetActorTickEnabled(false);
+
+    if (Actor->Implements<UPooledObstacle>())
+    {
+        IPooledObstacle::Execute_OnParkedInPool(Actor);
+    }
+}
+
+void UObstaclePoolSubsystem::ActivateActor(AActor* Actor, const FTransform& Transform, bool bEnableCollision)
+{
+    // Teleport with a full transform so nothing from the previous use (scale, physics velocity) leaks through
+    Actor->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+    Actor->SetActorHiddenInGame(false);
+    Actor->SetActorEnableCollision(bEnableCollision);
+    Actor->SetActorTickEnabled(Actor->PrimaryActorTick.bStartWithTickEnabled);
+
+    // Whatever the actor derived from its location in BeginPlay is stale now
+    if (Actor->Implements<UPooledObstacle>())
+    {
+        IPooledObstacle::Execute_OnAcquiredFromPool(Actor);
+    }
+}
@@ -0,0 +1,282 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleSpawnerBenchmarkCommandlet.h"
+#include "ObstacleCountingMalloc.h"
+#include "ObstacleSpawner.h"
+#include "ObstaclePoolSubsystem.h"
+#include "ObstacleSpawnerStats.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/PlatformMemory.h"
+#include "JsonObjectConverter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectGlobals.h"
+
+namespace
+{
+    FObstacleBenchmarkTimings SummarizeTimings(TArray<double>& SamplesMs)
+    {
+        FObstacleBenchmarkTimings Timings;
+        if (SamplesMs.Num() == 0)
+        {
+            return Timings;
+        }
+
+        SamplesMs.Sort();
+        const auto Percentile = [&SamplesMs](double Fraction)
+        {
+            const int32 Index = FMath::Clamp(FMath::CeilToInt32(Fraction * SamplesMs.Num()) - 1, 0, SamplesMs.Num() - 1);
+            return SamplesMs[Index];
+        };
+
+        double TotalMs = 0.0;
+        for (const double Sample : SamplesMs)
+        {
+            TotalMs += Sample;
+        }
+        Timings.MeanMs = TotalMs / SamplesMs.Num();
+        Timings.P50Ms = Percentile(0.5);
+        Timings.P90Ms = Percentile(0.9);
+        Timings.P99Ms = Percentile(0.99);
+        Timings.MaxMs = SamplesMs.Last();
+        return Timings;
+    }
+
+    double GetUsedMB()
+    {
+        return FPlatformMemory::GetStats().UsedPhysical / (1024.0 * 1024.0);
+    }
+
+    // A mix of what the game track uses: plain meshes in most slots, a pooled actor type and one type with planes
+    FObstacleSpawnParameters MakeBenchmarkParameters()
+    {
+        FObstacleSpawnParameters Parameters;
+        Parameters.NumObstacles = 20;
+        Parameters.SpacingBetweenObstacles = 1000.0f;
+
+        FObstacleSpawnInfo& Cube = Parameters.ObstacleTypes.AddDefaulted_GetRef();
+        Cube.StaticMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+        Cube.SpawnWeight = 3.0f;
+
+        FObstacleSpawnInfo& Cylinder = Parameters.ObstacleTypes.AddDefaulted_GetRef();
+        Cylinder.StaticMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cylinder.Cylinder"));
+        Cylinder.PlaneMesh = AStaticMeshActor::StaticClass();
+        Cylinder.PlaneSpawnProbability = 0.5f;
+        Cylinder.PoolPrewarmCount = 32;
+
+        FObstacleSpawnInfo& Blocker = Parameters.ObstacleTypes.AddDefaulted_GetRef();
+        Blocker.ObstacleActorClass = AStaticMeshActor::StaticClass();
+        Blocker.PoolPrewarmCount = 64;
+
+        FObstacleSpawnInfo& Sphere = Parameters.ObstacleTypes.AddDefaulted_GetRef();
+        Sphere.StaticMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Sphere.Sphere"));
+        Sphere.Scale = FVector(2.0f, 2.0f, 2.0f);
+        Sphere.SpacingAfterindevisualObstacles = 500.0f;
+        return Parameters;
+    }
+}
+
+UObstacleSpawnerBenchmarkCommandlet::UObstacleSpawnerBenchmarkCommandlet()
+{
+    IsClient = false;
+    IsServer = false;
+    LogToConsole = true;
+}
+
+int32 UObstacleSpawnerBenchmarkCommandlet::Main(const FString& Params)
+{
+    int32 NumChunks = 2000;
+    int32 NumWarmupChunks = 100;
+    int32 Seed = 1337;
+    int32 GCInterval = 60;
+    float Threshold = 0.1f;
+    FString OutputPath = FPaths::ProjectSavedDir() / TEXT("Benchmarks/ObstacleSpawner.json");
+    FString BaselinePath = FPaths::ProjectDir() / TEXT("Benchmarks/ObstacleSpawnerBaseline.json");
+    FParse::Value(*Params, TEXT("Chunks="), NumChunks);
+    FParse::Value(*Params, TEXT("Warmup="), NumWarmupChunks);
+    FParse::Value(*Params, TEXT("Seed="), Seed);
+    FParse::Value(*Params, TEXT("GCInterval="), GCInterval);
+    FParse::Value(*Params, TEXT("Threshold="), Threshold);
+    FParse::Value(*Params, TEXT("Output="), OutputPath);
+    FParse::Value(*Params, TEXT("Baseline="), BaselinePath);
+    const bool bWriteBaseline = FParse::Param(*Params, TEXT("WriteBaseline"));
+    NumChunks = FMath::Max(NumChunks, 1);
+    NumWarmupChunks = FMath::Max(NumWarmupChunks, 0);
+    GCInterval = FMath::Max(GCInterval, 1);
+
+    UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("ObstacleSpawnerBenchmark"));
+    FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+    WorldContext.SetCurrentWorld(World);
+    World->InitializeActorsForPlay(FURL());
+    World->BeginPlay();
+    // There is no game mode in a commandlet world, so nothing would start the match and dispatch BeginPlay.
+    // This is the call the game state makes once it does, from here on spawned actors begin play as they finish
+    World->GetWorldSettings()->NotifyBeginPlay();
+
+    const FObstacleSpawnParameters Parameters = MakeBenchmarkParameters();
+    AObstacleSpawner* Spawner = World->SpawnActorDeferred<AObstacleSpawner>(AObstacleSpawner::StaticClass(), FTransform::Identity);
+    Spawner->RandomSeed = Seed;
+    Spawner->SpawnParameters = Parameters;
+    Spawner->FinishSpawning(FTransform::Identity);
+
+    // Without BeginPlay the seed is not applied and nothing is pooled or prewarmed, the numbers would mean nothing
+    if (!Spawner->HasActorBegunPlay() || !Spawner->ObstaclePool)
+    {
+        UE_LOG(LogObstacleSpawner, Error, TEXT("The spawner did not begin play, or found no obstacle pool"));
+        GEngine->DestroyWorldContext(World);
+        World->DestroyWorld(false);
+        return 1;
+    }
+
+    TArray<FVector> LanePositions = { FVector(-300.0f, 0.0f, 0.0f), FVector(0.0f, 0.0f, 0.0f), FVector(300.0f, 0.0f, 0.0f) };
+    // Reused like a game caller would, so the counted allocations are the spawner's own
+    TArray<AActor*> SpawnedActors;
+    TArray<double> SpawnMs;
+    TArray<double> GarbageCollectionMs;
+    SpawnMs.Reserve(NumChunks);
+
+    FObstacleBenchmarkReport Report;
+    Report.Seed = Seed;
+    Report.Chunks = NumChunks;
+    Report.WarmupChunks = NumWarmupChunks;
+    Report.ObstaclesPerChunk = Parameters.NumObstacles;
+    Report.StartUsedMB = GetUsedMB();
+    Report.PeakUsedMB = Report.StartUsedMB;
+
+    // Counts this thread only, what the task graph and loading threads allocate meanwhile is not the spawner's.
+    // Left installed only for the run. It is never deleted, another thread may still be inside it when it is taken out
+    FObstacleCountingMalloc* CountingMalloc = new FObstacleCountingMalloc(GMalloc);
+    GMalloc = CountingMalloc;
+    uint64 NumAllocations = 0;
+    uint64 AllocatedBytes = 0;
+
+    float ChunkY = 0.0f;
+    for (int32 Chunk = 0; Chunk < NumWarmupChunks + NumChunks; ++Chunk)
+    {
+        const bool bMeasured = Chunk >= NumWarmupChunks;
+        for (FVector& LanePosition : LanePositions)
+        {
+            LanePosition.Y = ChunkY;
+        }
+
+        const uint64 AllocationsBefore = CountingMalloc->GetNumAllocations();
+        const uint64 BytesBefore = CountingMalloc->GetAllocatedBytes();
+        const uint64 StartCycles = FPlatformTime::Cycles64();
+        SpawnedActors.Reset();
+        Spawner->SpawnObstaclesBatch(Parameters, LanePositions, SpawnedActors);
+        const double ChunkMs = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+        if (bMeasured)
+        {
+            SpawnMs.Add(ChunkMs);
+            NumAllocations += CountingMalloc->GetNumAllocations() - AllocationsBefore;
+            AllocatedBytes += CountingMalloc->GetAllocatedBytes() - BytesBefore;
+        }
+
+        // The runner has reached this chunk, everything behind it goes back to the pools as it would in the game
+        Spawner->DespawnObstaclesBehind(ChunkY);
+        ChunkY = Spawner->TrackedObstacles.Num() > 0 ? Spawner->TrackedObstacles.Last().Y + Parameters.SpacingBetweenObstacles : ChunkY + Parameters.NumObstacles * Parameters.SpacingBetweenObstacles;
+
+        if ((Chunk + 1) % GCInterval == 0)
+        {
+            const uint64 GCStartCycles = FPlatformTime::Cycles64();
+            CollectGarbage(GARBAGE_COLLECTION_KEEPFLAGS);
+            if (bMeasured)
+            {
+                GarbageCollectionMs.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - GCStartCycles));
+            }
+            Report.PeakUsedMB = FMath::Max(Report.PeakUsedMB, GetUsedMB());
+        }
+    }
+
+    GMalloc = CountingMalloc->GetUsedMalloc();
+
+    Report.Spawn = SummarizeTimings(SpawnMs);
+    Report.GarbageCollection = SummarizeTimings(GarbageCollectionMs);
+    Report.AllocationsPerChunk = static_cast<double>(NumAllocations) / NumChunks;
+    Report.AllocatedKBPerChunk = AllocatedBytes / 1024.0 / NumChunks;
+    Report.EndUsedMB = GetUsedMB();
+    Report.PeakUsedMB = FMath::Max(Report.PeakUsedMB, Report.EndUsedMB);
+
+    // Every pooled type in MakeBenchmarkParameters is an AStaticMeshActor
+    const FObstaclePoolStats PoolStats = Spawner->ObstaclePool->GetPoolStats(AStaticMeshActor::StaticClass());
+    Report.PoolHits = PoolStats.Hits;
+    Report.PoolMisses = PoolStats.Misses;
+
+    GEngine->DestroyWorldContext(World);
+    World->DestroyWorld(false);
+
+    // Warm-up has filled the pools and scratch arrays, so a spawn after it has no reason to touch the heap
+    if (NumAllocations > 0)
+    {
+        Report.Regressions.Add(FString::Printf(TEXT("AllocationsPerChunk %.3f after warm-up, expected 0"), Report.AllocationsPerChunk));
+    }
+    if (Report.PoolHits == 0)
+    {
+        Report.Regressions.Add(FString::Printf(TEXT("No pooled actor was reused (%d misses), the pool is not in the measured path"), Report.PoolMisses));
+    }
+
+    FString BaselineJson;
+    FObstacleBenchmarkReport Baseline;
+    bool bMissingBaseline = false;
+    if (!bWriteBaseline)
+    {
+        bMissingBaseline = !FFileHelper::LoadFileToString(BaselineJson, *BaselinePath) || !FJsonObjectConverter::JsonObjectStringToUStruct(BaselineJson, &Baseline);
+        if (bMissingBaseline)
+        {
+            UE_LOG(LogObstacleSpawner, Error, TEXT("No readable baseline at %s, run with -WriteBaseline on the reference machine to record one"), *BaselinePath);
+        }
+        else
+        {
+            CompareToBaseline(Baseline, Threshold, Report);
+        }
+    }
+
+    FString ReportJson;
+    FJsonObjectConverter::UStructToJsonObjectString(Report, ReportJson);
+    // A run that failed on its own must not become the baseline, the report still goes to Output
+    const FString& WritePath = bWriteBaseline && Report.Regressions.Num() == 0 ? BaselinePath : OutputPath;
+    if (!FFileHelper::SaveStringToFile(ReportJson, *WritePath))
+    {
+        UE_LOG(LogObstacleSpawner, Error, TEXT("Could not write %s"), *WritePath);
+        return 1;
+    }
+
+    UE_LOG(LogObstacleSpawner, Display, TEXT("%d chunks: spawn p50 %.3f ms, p99 %.3f ms, %.1f allocations per chunk, GC mean %.2f ms, peak %.1f MB. Wrote %s"),
+        Report.Chunks, Report.Spawn.P50Ms, Report.Spawn.P99Ms, Report.AllocationsPerChunk, Report.GarbageCollection.MeanMs, Report.PeakUsedMB, *WritePath);
+
+    for (const FString& Regression : Report.Regressions)
+    {
+        UE_LOG(LogObstacleSpawner, Error, TEXT("Regression: %s"), *Regression);
+    }
+    return Report.Regressions.Num() > 0 || bMissingBaseline ? 1 : 0;
+}
+
+void UObstacleSpawnerBenchmarkCommandlet::CompareToBaseline(const FObstacleBenchmarkReport& Baseline, float Threshold, FObstacleBenchmarkReport& Report)
+{
+    if (Baseline.Seed != Report.Seed || Baseline.Chunks != Report.Chunks || Baseline.ObstaclesPerChunk != Report.ObstaclesPerChunk)
+    {
+        UE_LOG(LogObstacleSpawner, Warning, TEXT("The baseline was recorded with a different seed or chunk count, the comparison is only approximate"));
+    }
+
+    const auto Check = [Threshold, &Report](const TCHAR* Name, double Value, double BaselineValue)
+    {
+        // A zero baseline, e.g. no allocations, fails on anything above it
+        if (Value > BaselineValue * (1.0 + Threshold))
+        {
+            Report.Regressions.Add(FString::Printf(TEXT("%s %.3f, baseline %.3f"), Name, Value, BaselineValue));
+        }
+    };
+
+    Check(TEXT("Spawn.P50Ms"), Report.Spawn.P50Ms, Baseline.Spawn.P50Ms);
+    Check(TEXT("Spawn.P90Ms"), Report.Spawn.P90Ms, Baseline.Spawn.P90Ms);
+    Check(TEXT("Spawn.P99Ms"), Report.Spawn.P99Ms, Baseline.Spawn.P99Ms);
+    Check(TEXT("AllocationsPerChunk"), Report.AllocationsPerChunk, Baseline.AllocationsPerChunk);
+    Check(TEXT("AllocatedKBPerChunk"), Report.AllocatedKBPerChunk, Baseline.AllocatedKBPerChunk);
+    Check(TEXT("GarbageCollection.MeanMs"), Report.GarbageCollection.MeanMs, Baseline.GarbageCollection.MeanMs);
+    Check(TEXT("PeakUsedMB"), Report.PeakUsedMB, Baseline.PeakUsedMB);
+}
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleSpawnerStats.h"
+
+DEFINE_LOG_CATEGORY(LogObstacleSpawner);
+CSV_DEFINE_CATEGORY_MODULE(UCFGMS_API, ObstacleSpawner, true);
+UE_TRACE_CHANNEL_DEFINE(ObstacleSpawnerChannel);
+
+DEFINE_STAT(STAT_SpawnStaticMeshComponent);
+DEFINE_STAT(STAT_SpawnSkeletalMeshComponent);
+DEFINE_STAT(STAT_RecycledComponentHits);
+DEFINE_STAT(STAT_RecycledComponentMisses);
+DEFINE_STAT(STAT_ParkedComponents);
+DEFINE_STAT(STAT_SpawnInstancedObstacle);
+DEFINE_STAT(STAT_InstancedObstacles);
+DEFINE_STAT(STAT_ObstacleInstanceBatches);
+DEFINE_STAT(STAT_ProcessPendingObstacles);
+DEFINE_STAT(STAT_PendingObstaclesFrameMs);
+DEFINE_STAT(STAT_PendingObstaclesSpawnedThisFrame);
+DEFINE_STAT(STAT_PrefetchedObstacleAssets);
+DEFINE_STAT(STAT_ObstaclePrefetchMisses);
+DEFINE_STAT(STAT_ApplyPlannedChunk);
+DEFINE_STAT(STAT_RecycledTrackChunks);
+DEFINE_STAT(STAT_DespawnPassedObstacles);
+DEFINE_STAT(STAT_TrackedObstacles);
+DEFINE_STAT(STAT_LiveObstacleActors);
+DEFINE_STAT(STAT_LiveObstacleComponents);
+DEFINE_STAT(STAT_DespawnedObstacles);
+DEFINE_STAT(STAT_SpawnObstacles);
+DEFINE_STAT(STAT_ObstaclesPerSpawnCall);
+DEFINE_STAT(STAT_SpawnObstacleActor);
+DEFINE_STAT(STAT_SpawnPlane);
+DEFINE_STAT(STAT_PlaneSpawns);
+DEFINE_STAT(STAT_PooledActorsInUse);
+DEFINE_STAT(STAT_PooledActorsParked);
+DEFINE_STAT(STAT_TickMovers);
+DEFINE_STAT(STAT_AwakeMovers);
+DEFINE_STAT(STAT_UpdateTickLOD);
+DEFINE_STAT(STAT_TickLODFullRate);
+DEFINE_STAT(STAT_TickLODReduced);
+DEFINE_STAT(STAT_TickLODSuspended);
+DEFINE_STAT(STAT_RebaseWorldOrigin);
+DEFINE_STAT(STAT_WorldOriginRebases);
+DEFINE_STAT(STAT_PromoteObstacleEntities);
+DEFINE_STAT(STAT_ObstacleEntities);
+DEFINE_STAT(STAT_PromotedObstacleEntities);
+DEFINE_STAT(STAT_ResolveGroundSnaps);
+DEFINE_STAT(STAT_GroundSnapTraces);
+DEFINE_STAT(STAT_GroundSnapMisses);
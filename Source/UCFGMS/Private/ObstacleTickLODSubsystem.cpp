@@ -0,0 +1,262 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleTickLODSubsystem.h"
+#include "ObstacleSpawnerStats.h"
+#include "Components/ActorComponent.h"
+#include "GameFramework/Pawn.h"
+#include "Kismet/GameplayStatics.h"
+
+namespace
+{
+    // Long enough that a suspended actor never ticks before the player comes back in range, and changing the
+    // interval then reschedules it
+    constexpr float SuspendedTickInterval = 3600.0f;
+}
+
+UObstacleTickLODSubsystem::UObstacleTickLODSubsystem()
+{
+    FTickLODBucket& Near = Buckets.AddDefaulted_GetRef();
+    Near.MaxDistance = 5000.0f;
+
+    FTickLODBucket& Mid = Buckets.AddDefaulted_GetRef();
+    Mid.MaxDistance = 15000.0f;
+    Mid.TickInterval = 0.1f;
+
+    FTickLODBucket& Far = Buckets.AddDefaulted_GetRef();
+    Far.MaxDistance = 40000.0f;
+    Far.TickInterval = 0.5f;
+
+    BucketCounts.Init(0, Buckets.Num() + 1);
+}
+
+void UObstacleTickLODSubsystem::Deinitialize()
+{
+    Entries.Empty();
+    EntryIndices.Empty();
+    BucketCounts.Init(0, Buckets.Num() + 1);
+    UpdateCounters();
+    Super::Deinitialize();
+}
+
+TStatId UObstacleTickLODSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UObstacleTickLODSubsystem, STATGROUP_Tickables);
+}
+
+void UObstacleTickLODSubsystem::SetBuckets(const TArray<FTickLODBucket>& InBuckets)
+{
+    Buckets = InBuckets;
+    Buckets.Sort([](const FTickLODBucket& A, const FTickLODBucket& B)
+    {
+        return A.MaxDistance < B.MaxDistance;
+    });
+
+    // Bucket indices changed meaning, everything is re-bucketed from scratch
+    BucketCounts.Init(0, Buckets.Num() + 1);
+    for (FEntry& Entry : Entries)
+    {
+        Entry.Bucket = INDEX_NONE;
+    }
+}
+
+void UObstacleTickLODSubsystem::Register(AActor* Actor)
+{
+    if (!Actor || EntryIndices.Contains(Actor))
+    {
+        return;
+    }
+
+    // Bucketed on its first turn, until then it keeps its own tick settings
+    FEntry& Entry = Entries.AddDefaulted_GetRef();
+    Entry.Actor = Actor;
+    Entry.OriginalTickInterval = Actor->GetActorTickInterval();
+    Actor->ForEachComponent(false, [&Entry](UActorComponent* Component)
+    {
+        Entry.OriginalComponentIntervals.Emplace(Component, Component->GetComponentTickInterval());
+    });
+    EntryIndices.Add(Actor, Entries.Num() - 1);
+}
+
+void UObstacleTickLODSubsystem::Unregister(AActor* Actor)
+{
+    if (const int32* Index = EntryIndices.Find(Actor))
+    {
+        RemoveEntry(*Index);
+    }
+}
+
+void UObstacleTickLODSubsystem::RemoveEntry(int32 Index)
+{
+    FEntry& Entry = Entries[Index];
+    if (AActor* Actor = Entry.Actor.Get())
+    {
+        Actor->SetActorTickInterval(Entry.OriginalTickInterval);
+        for (const TPair<TWeakObjectPtr<UActorComponent>, float>& Original : Entry.OriginalComponentIntervals)
+        {
+            if (UActorComponent* Component = Original.Key.Get())
+            {
+                Component->SetComponentTickInterval(Original.Value);
+            }
+        }
+        EntryIndices.Remove(Actor);
+    }
+    else
+    {
+        // Already gone, find its key the slow way
+        for (auto It = EntryIndices.CreateIterator(); It; ++It)
+        {
+            if (It.Value() == Index)
+            {
+                It.RemoveCurrent();
+                break;
+            }
+        }
+    }
+
+    if (BucketCounts.IsValidIndex(Entry.Bucket))
+    {
+        --BucketCounts[Entry.Bucket];
+    }
+
+    Entries.RemoveAtSwap(Index, 1, false);
+    if (Entries.IsValidIndex(Index))
+    {
+        if (const AActor* Moved = Entries[Index].Actor.Get())
+        {
+            EntryIndices.Add(Moved, Index);
+        }
+    }
+}
+
+float UObstacleTickLODSubsystem::GetUpdateInterval(const AActor* Actor) const
+{
+    const int32* Index = EntryIndices.Find(Actor);
+    if (!Index || Entries[*Index].Bucket == INDEX_NONE)
+    {
+        return 0.0f;
+    }
+    return GetBucketInterval(Entries[*Index].Bucket);
+}
+
+int32 UObstacleTickLODSubsystem::FindBucket(float Distance) const
+{
+    for (int32 Bucket = 0; Bucket < Buckets.Num(); ++Bucket)
+    {
+        if (Distance <= Buckets[Bucket].MaxDistance)
+        {
+            return Bucket;
+        }
+    }
+    return Buckets.Num();
+}
+
+float UObstacleTickLODSubsystem::GetBucketInterval(int32 Bucket) const
+{
+    if (Buckets.IsValidIndex(Bucket) && !Buckets[Bucket].bSuspendTick)
+    {
+        return Buckets[Bucket].TickInterval;
+    }
+
+    // Suspended, what still ticks goes at the slowest interval of the other buckets
+    float Interval = 0.0f;
+    for (const FTickLODBucket& Other : Buckets)
+    {
+        Interval = Other.bSuspendTick ? Interval : FMath::Max(Interval, Other.TickInterval);
+    }
+    return Interval;
+}
+
+void UObstacleTickLODSubsystem::ApplyBucket(FEntry& Entry, int32 Bucket)
+{
+    AActor* Actor = Entry.Actor.Get();
+    const bool bSuspend = !Buckets.IsValidIndex(Bucket) || Buckets[Bucket].bSuspendTick;
+    const float Interval = GetBucketInterval(Bucket);
+
+    // Never tick faster than the actor or component asked for
+    Actor->SetActorTickInterval(bSuspend ? SuspendedTickInterval : FMath::Max(Interval, Entry.OriginalTickInterval));
+    for (const TPair<TWeakObjectPtr<UActorComponent>, float>& Original : Entry.OriginalComponentIntervals)
+    {
+        if (UActorComponent* Component = Original.Key.Get())
+        {
+            Component->SetComponentTickInterval(FMath::Max(Interval, Original.Value));
+        }
+    }
+
+    if (BucketCounts.IsValidIndex(Entry.Bucket))
+    {
+        --BucketCounts[Entry.Bucket];
+    }
+    ++BucketCounts[Bucket];
+    Entry.Bucket = Bucket;
+}
+
+void UObstacleTickLODSubsystem::Tick(float DeltaTime)
+{
+    SCOPE_CYCLE_COUNTER(STAT_UpdateTickLOD);
+
+    const APawn* PlayerPawn = UGameplayStatics::GetPlayerPawn(this, 0);
+    if (!PlayerPawn || Entries.Num() == 0)
+    {
+        return;
+    }
+
+    // Round robin, so the cost per frame stays flat however many actors are registered
+    const float PlayerY = PlayerPawn->GetActorLocation().Y;
+    const int32 NumToUpdate = FMath::Min(MaxActorsPerFrame, Entries.Num());
+    for (int32 Updated = 0; Updated < NumToUpdate && Entries.Num() > 0; ++Updated)
+    {
+        if (NextEntry >= Entries.Num())
+        {
+            NextEntry = 0;
+        }
+
+        FEntry& Entry = Entries[NextEntry];
+        const AActor* Actor = Entry.Actor.Get();
+        if (!IsValid(Actor))
+        {
+            // The swapped-in entry takes this index and gets its turn next
+            RemoveEntry(NextEntry);
+            continue;
+        }
+
+        const int32 Bucket = FindBucket(FMath::Abs(Actor->GetActorLocation().Y - PlayerY));
+        if (Bucket != Entry.Bucket)
+        {
+            ApplyBucket(Entry, Bucket);
+        }
+        ++NextEntry;
+    }
+
+    UpdateCounters();
+}
+
+void UObstacleTickLODSubsystem::UpdateCounters() const
+{
+    // Rolled up into full rate, reduced and suspended, whatever the bucket setup
+    int32 NumFullRate = 0;
+    int32 NumReduced = 0;
+    int32 NumSuspended = 0;
+    for (int32 Bucket = 0; Bucket < BucketCounts.Num(); ++Bucket)
+    {
+        if (!Buckets.IsValidIndex(Bucket) || Buckets[Bucket].bSuspendTick)
+        {
+            NumSuspended += BucketCounts[Bucket];
+        }
+        else if (Buckets[Bucket].TickInterval > 0.0f)
+        {
+            NumReduced += BucketCounts[Bucket];
+        }
+        else
+        {
+            NumFullRate += BucketCounts[Bucket];
+        }
+    }
+
+    SET_DWORD_STAT(STAT_TickLODFullRate, NumFullRate);
+    SET_DWORD_STAT(STAT_TickLODReduced, NumReduced);
+    SET_DWORD_STAT(STAT_TickLODSuspended, NumSuspended);
+    CSV_CUSTOM_STAT(ObstacleSpawner, TickLODFullRate, NumFullRate, ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(ObstacleSpawner, TickLODReduced, NumReduced, ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(ObstacleSpawner, TickLODSuspended, NumSuspended, ECsvCustomStatOp::Set);
+}
@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleTestWorld.h"
+#include "ObstaclePoolSubsystem.h"
+#include "EngineUtils.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    int32 CountActors(UWorld* World)
+    {
+        int32 NumActors = 0;
+        for (TActorIterator<AActor> It(World); It; ++It)
+        {
+            ++NumActors;
+        }
+        return NumActors;
+    }
+}
+
+// Runs the chunk stream for a long stretch of track and checks that nothing it keeps grows with the distance run
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FObstacleChunkStreamSoakTest, "UCFGMS.Obstacles.ChunkStream.LongRunBounded", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FObstacleChunkStreamSoakTest::RunTest(const FString& Parameters)
+{
+    // 9000 steps of 400 units is 3.6 km of track, about an hour of running at 1000 units per second
+    constexpr int32 NumSteps = 9000;
+    constexpr float RunnerStep = 400.0f;
+    constexpr int32 RingSize = 4;
+
+    FObstacleTestWorld TestWorld;
+    const FObstacleSpawnParameters SpawnParameters = FObstacleTestWorld::MakeMixedParameters();
+    AObstacleSpawner* Spawner = TestWorld.SpawnSpawner([&SpawnParameters](AObstacleSpawner& NewSpawner)
+    {
+        NewSpawner.RandomSeed = 1337;
+        NewSpawner.SpawnParameters = SpawnParameters;
+        NewSpawner.ChunkRingSize = RingSize;
+        NewSpawner.bUseObstacleEntities = true;
+        NewSpawner.EntityPromotionDistance = 8000.0f;
+        // The whole chunk spawns in its first frame, so the counts do not depend on how fast this machine is
+        NewSpawner.SpawnBudgetMs = 1000.0f;
+    });
+    UObstaclePoolSubsystem* Pool = FObstacleSpawnerTestAccess::GetPool(*Spawner);
+    if (!TestNotNull(TEXT("Obstacle pool"), Pool))
+    {
+        return false;
+    }
+
+    const int32 InitialActors = CountActors(TestWorld.GetWorld());
+    const TArray<FVector> LanePositions = { FVector(-300.0f, 0.0f, 0.0f), FVector(0.0f, 0.0f, 0.0f), FVector(300.0f, 0.0f, 0.0f) };
+    Spawner->StartChunkStream(LanePositions);
+
+    int32 MaxActiveChunks = 0;
+    int32 MaxTracked = 0;
+    int32 MaxEntities = 0;
+    int32 MaxLaneEntries = 0;
+    int32 MaxParkedComponents = 0;
+    int32 MaxActors = 0;
+    float RunnerY = 0.0f;
+    for (int32 Step = 0; Step < NumSteps; ++Step)
+    {
+        FObstacleSpawnerTestAccess::Step(*Spawner, RunnerY);
+        MaxActiveChunks = FMath::Max(MaxActiveChunks, FObstacleSpawnerTestAccess::GetNumActiveChunks(*Spawner));
+        MaxTracked = FMath::Max(MaxTracked, Spawner->GetNumTrackedObstacles());
+        MaxEntities = FMath::Max(MaxEntities, Spawner->GetNumObstacleEntities());
+        MaxLaneEntries = FMath::Max(MaxLaneEntries, FObstacleSpawnerTestAccess::GetNumLaneEntries(*Spawner));
+        MaxParkedComponents = FMath::Max(MaxParkedComponents, FObstacleSpawnerTestAccess::GetNumParkedComponents(*Spawner));
+        if (Step % 100 == 0)
+        {
+            MaxActors = FMath::Max(MaxActors, CountActors(TestWorld.GetWorld()));
+        }
+
+        // The runner never gets ahead of the track that exists
+        RunnerY = FMath::Min(RunnerY + RunnerStep, FObstacleSpawnerTestAccess::GetStreamEndY(*Spawner));
+    }
+
+    TestTrue(TEXT("The runner covered the whole distance"), RunnerY >= 0.9f * NumSteps * RunnerStep);
+    // Chunks far behind the runner would mean the ring stopped recycling and the stream only kept up by growing
+    TestTrue(TEXT("The ring kept recycling"), FObstacleSpawnerTestAccess::GetOldestChunkEndY(*Spawner) > 0.5f * RunnerY);
+
+    // Everything the stream keeps is capped by the ring, however far the runner got
+    const int32 RingObstacles = RingSize * SpawnParameters.NumObstacles;
+    TestTrue(FString::Printf(TEXT("Active chunks %d within the ring of %d"), MaxActiveChunks, RingSize), MaxActiveChunks <= RingSize);
+    TestTrue(FString::Printf(TEXT("Tracked obstacles %d within %d"), MaxTracked, RingObstacles), MaxTracked <= RingObstacles);
+    TestTrue(FString::Printf(TEXT("Obstacle entities %d within %d"), MaxEntities, RingObstacles), MaxEntities <= RingObstacles);
+    TestTrue(FString::Printf(TEXT("Lane index entries %d within %d"), MaxLaneEntries, RingObstacles), MaxLaneEntries <= RingObstacles);
+    TestTrue(FString::Printf(TEXT("Parked components %d within %d"), MaxParkedComponents, RingObstacles), MaxParkedComponents <= RingObstacles);
+
+    // Obstacles and their planes, a miss only happens with every pooled actor in use so misses stay under the high water mark
+    const FObstaclePoolStats PoolStats = Pool->GetPoolStats(AStaticMeshActor::StaticClass());
+    TestTrue(FString::Printf(TEXT("Pool high water mark %d within %d"), PoolStats.HighWaterMark, 2 * RingObstacles), PoolStats.HighWaterMark <= 2 * RingObstacles);
+    TestTrue(FString::Printf(TEXT("Pool misses %d within the high water mark %d"), PoolStats.Misses, PoolStats.HighWaterMark), PoolStats.Misses <= PoolStats.HighWaterMark);
+    TestTrue(TEXT("The pool was reused"), PoolStats.Hits > PoolStats.Misses);
+    TestTrue(FString::Printf(TEXT("World actors %d within %d"), MaxActors, InitialActors + 2 * RingObstacles), MaxActors <= InitialActors + 2 * RingObstacles);
+
+    // Stopping hands everything back
+    Spawner->StopChunkStream();
+    TestEqual(TEXT("No tracked obstacles after stopping"), Spawner->GetNumTrackedObstacles(), 0);
+    TestEqual(TEXT("No obstacle entities after stopping"), Spawner->GetNumObstacleEntities(), 0);
+    TestEqual(TEXT("No lane index entries after stopping"), FObstacleSpawnerTestAccess::GetNumLaneEntries(*Spawner), 0);
+    TestEqual(TEXT("No pooled actors in use after stopping"), Pool->GetPoolStats(AStaticMeshActor::StaticClass()).InUse, 0);
+    return true;
+}
+
+// Without a player there is no lookahead to fall back on, so promotion has to stop at the spawn budget
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FObstacleEntityPromotionBudgetTest, "UCFGMS.Obstacles.ChunkStream.PromotionBudgetWithoutPlayer", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FObstacleEntityPromotionBudgetTest::RunTest(const FString& Parameters)
+{
+    FObstacleTestWorld TestWorld;
+    const FObstacleSpawnParameters SpawnParameters = FObstacleTestWorld::MakeMixedParameters();
+    AObstacleSpawner* Spawner = TestWorld.SpawnSpawner([&SpawnParameters](AObstacleSpawner& NewSpawner)
+    {
+        NewSpawner.RandomSeed = 1337;
+        NewSpawner.SpawnParameters = SpawnParameters;
+        NewSpawner.ChunkRingSize = 2;
+        NewSpawner.bUseObstacleEntities = true;
+        NewSpawner.EntityPromotionDistance = 2000.0f;
+        // Over budget after the first obstacle of every frame
+        NewSpawner.SpawnBudgetMs = 0.0f;
+    });
+
+    // Fill the ring with the player at the start, so the rest of both chunks is stored as entities
+    const TArray<FVector> LanePositions = { FVector(-300.0f, 0.0f, 0.0f), FVector(0.0f, 0.0f, 0.0f), FVector(300.0f, 0.0f, 0.0f) };
+    Spawner->StartChunkStream(LanePositions);
+    FObstacleSpawnerTestAccess::Step(*Spawner, 0.0f);
+    FObstacleSpawnerTestAccess::Step(*Spawner, 0.0f);
+    const int32 NumEntities = Spawner->GetNumObstacleEntities();
+    if (!TestTrue(TEXT("Entities to promote"), NumEntities >= 2))
+    {
+        Spawner->StopChunkStream();
+        return false;
+    }
+
+    // The ring is full and only recycles behind a player, so promotion is the only thing changing the count
+    FObstacleSpawnerTestAccess::UpdateWithoutPlayer(*Spawner);
+    TestEqual(TEXT("One entity promoted in the first frame without a player"), Spawner->GetNumObstacleEntities(), NumEntities - 1);
+    FObstacleSpawnerTestAccess::UpdateWithoutPlayer(*Spawner);
+    TestEqual(TEXT("One entity promoted in the second frame without a player"), Spawner->GetNumObstacleEntities(), NumEntities - 2);
+
+    Spawner->StopChunkStream();
+    return true;
+}
+
+#endif
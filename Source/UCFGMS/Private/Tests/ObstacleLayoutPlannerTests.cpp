@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleLayoutPlanner.h"
+#include "ObstaclePatternLibrary.h"
+#include "ObstacleSpawner.h"
+#include "HAL/FileManager.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    constexpr int32 TestSeed = 1337;
+    constexpr int32 TestLanes = 3;
+
+    // Three types of different lengths and gaps, so a spacing mistake shows up whichever type comes next
+    FObstacleSpawnParameters MakePlannerParameters(TArray<FBox>& OutFootprints)
+    {
+        FObstacleSpawnParameters Parameters;
+        Parameters.NumObstacles = 20;
+        Parameters.SpacingBetweenObstacles = 1000.0f;
+
+        const float Lengths[] = { 200.0f, 1500.0f, 600.0f };
+        for (int32 TypeIndex = 0; TypeIndex < UE_ARRAY_COUNT(Lengths); ++TypeIndex)
+        {
+            FObstacleSpawnInfo& SpawnInfo = Parameters.ObstacleTypes.AddDefaulted_GetRef();
+            SpawnInfo.SpawnWeight = 1.0f + TypeIndex;
+            SpawnInfo.SpacingAfterindevisualObstacles = TypeIndex * 100.0f;
+            OutFootprints.Add(FBox(FVector(-50.0f, -0.5f * Lengths[TypeIndex], 0.0f), FVector(50.0f, 0.5f * Lengths[TypeIndex], 100.0f)));
+        }
+        return Parameters;
+    }
+
+    // The library only loads from a file, so the patterns go through a transient one
+    TSharedPtr<const FObstaclePatternLibrary, ESPMode::ThreadSafe> MakePatternLibrary(const TArray<FObstaclePattern>& Patterns)
+    {
+        TArray<uint8> Bytes;
+        if (!FObstaclePatternLibrary::Write(Patterns, Bytes))
+        {
+            return nullptr;
+        }
+
+        const FString Filename = FPaths::AutomationTransientDir() / TEXT("ObstacleLayoutPlannerTests.obpl");
+        if (!FFileHelper::SaveArrayToFile(Bytes, *Filename))
+        {
+            return nullptr;
+        }
+        TSharedPtr<const FObstaclePatternLibrary, ESPMode::ThreadSafe> Library = FObstaclePatternLibrary::Load(Filename);
+        // Platforms that cannot delete a mapped file leave it behind, the next run overwrites it
+        IFileManager::Get().Delete(*Filename, false, false, true);
+        return Library;
+    }
+
+    FObstaclePatternObstacle MakePatternObstacle(int32 TypeIndex, int32 Lane, float OffsetY)
+    {
+        FObstaclePatternObstacle Obstacle;
+        Obstacle.TypeIndex = TypeIndex;
+        Obstacle.Lane = Lane;
+        Obstacle.OffsetY = OffsetY;
+        return Obstacle;
+    }
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FObstacleLayoutPlannerCountTest, "UCFGMS.Obstacles.LayoutPlanner.PlacementCount", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FObstacleLayoutPlannerCountTest::RunTest(const FString& Parameters)
+{
+    TArray<FBox> Footprints;
+    const FObstacleSpawnParameters SpawnParameters = MakePlannerParameters(Footprints);
+    FObstacleLayoutPlanner Planner;
+    Planner.Compile(SpawnParameters, Footprints);
+
+    FRandomStream FirstRandom(TestSeed);
+    TArray<FObstaclePlacement> First;
+    const float FirstEndY = Planner.Plan(0.0f, TestLanes, FirstRandom, First);
+
+    TestEqual(TEXT("One placement per obstacle"), First.Num(), SpawnParameters.NumObstacles);
+    for (const FObstaclePlacement& Placement : First)
+    {
+        TestTrue(TEXT("Type index in range"), Placement.TypeIndex < SpawnParameters.ObstacleTypes.Num());
+        TestTrue(TEXT("Lane index in range"), Placement.LaneIndex < TestLanes);
+        TestFalse(TEXT("No plane without a plane type"), static_cast<bool>(Placement.bSpawnPlane));
+    }
+
+    // The same seed has to give the same chunk, chunk streaming and the benchmark rely on it
+    FRandomStream SecondRandom(TestSeed);
+    TArray<FObstaclePlacement> Second;
+    const float SecondEndY = Planner.Plan(0.0f, TestLanes, SecondRandom, Second);
+    TestEqual(TEXT("Same end Y for the same seed"), SecondEndY, FirstEndY);
+    if (TestEqual(TEXT("Same count for the same seed"), Second.Num(), First.Num()))
+    {
+        for (int32 Index = 0; Index < First.Num(); ++Index)
+        {
+            TestEqual(TEXT("Same Y for the same seed"), Second[Index].Y, First[Index].Y);
+            TestEqual(TEXT("Same type for the same seed"), static_cast<int32>(Second[Index].TypeIndex), static_cast<int32>(First[Index].TypeIndex));
+            TestEqual(TEXT("Same lane for the same seed"), static_cast<int32>(Second[Index].LaneIndex), static_cast<int32>(First[Index].LaneIndex));
+        }
+    }
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FObstacleLayoutPlannerSpacingTest, "UCFGMS.Obstacles.LayoutPlanner.FootprintSpacing", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FObstacleLayoutPlannerSpacingTest::RunTest(const FString& Parameters)
+{
+    TArray<FBox> Footprints;
+    const FObstacleSpawnParameters SpawnParameters = MakePlannerParameters(Footprints);
+    FObstacleLayoutPlanner Planner;
+    Planner.Compile(SpawnParameters, Footprints);
+
+    constexpr float StartY = 5000.0f;
+    FRandomStream Random(TestSeed);
+    TArray<FObstaclePlacement> Placements;
+    const float EndY = Planner.Plan(StartY, TestLanes, Random, Placements);
+    if (!TestEqual(TEXT("One placement per obstacle"), Placements.Num(), SpawnParameters.NumObstacles))
+    {
+        return false;
+    }
+
+    // Every footprint starts where the previous one ended plus the spacing and that type's extra gap
+    float ExpectedFootprintStart = StartY;
+    for (const FObstaclePlacement& Placement : Placements)
+    {
+        const FBox& Footprint = Footprints[Placement.TypeIndex];
+        TestEqual(TEXT("Footprint starts at the cursor"), Placement.Y + static_cast<float>(Footprint.Min.Y), ExpectedFootprintStart, 0.01f);
+        ExpectedFootprintStart = Placement.Y + static_cast<float>(Footprint.Max.Y) + SpawnParameters.SpacingBetweenObstacles + SpawnParameters.ObstacleTypes[Placement.TypeIndex].SpacingAfterindevisualObstacles;
+    }
+    TestEqual(TEXT("The next chunk starts after the last footprint"), EndY, ExpectedFootprintStart, 0.01f);
+    return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FObstacleLayoutPlannerPatternTest, "UCFGMS.Obstacles.LayoutPlanner.PatternFallback", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FObstacleLayoutPlannerPatternTest::RunTest(const FString& Parameters)
+{
+    TArray<FBox> Footprints;
+    const FObstacleSpawnParameters SpawnParameters = MakePlannerParameters(Footprints);
+
+    // Four lanes wide, with one obstacle of a type the spawner does not have
+    FObstaclePattern Pattern;
+    Pattern.Length = 3000.0f;
+    Pattern.Obstacles.Add(MakePatternObstacle(0, 0, 0.0f));
+    Pattern.Obstacles.Add(MakePatternObstacle(1, 3, 500.0f));
+    Pattern.Obstacles.Add(MakePatternObstacle(99, 1, 1000.0f));
+    const TSharedPtr<const FObstaclePatternLibrary, ESPMode::ThreadSafe> Library = MakePatternLibrary({ Pattern });
+    if (!TestNotNull(TEXT("Pattern library"), Library.Get()))
+    {
+        return false;
+    }
+    TestEqual(TEXT("Max pattern obstacles from the records"), Library->GetMaxPatternObstacles(), Pattern.Obstacles.Num());
+
+    FObstacleLayoutPlanner Planner;
+    Planner.Compile(SpawnParameters, Footprints);
+    Planner.SetPatterns(Library, 1.0f);
+
+    // A track narrower than the pattern falls back to single obstacles for every slot
+    {
+        FRandomStream Random(TestSeed);
+        TArray<FObstaclePlacement> Placements;
+        Planner.Plan(0.0f, TestLanes, Random, Placements);
+        TestEqual(TEXT("Single obstacles on a narrow track"), Placements.Num(), SpawnParameters.NumObstacles);
+        for (const FObstaclePlacement& Placement : Placements)
+        {
+            TestTrue(TEXT("Fallback stays on the track"), Placement.LaneIndex < TestLanes);
+        }
+    }
+
+    // On a wide enough track every slot is the pattern, less the obstacle of the unknown type
+    {
+        constexpr float StartY = 100.0f;
+        FRandomStream Random(TestSeed);
+        TArray<FObstaclePlacement> Placements;
+        const float EndY = Planner.Plan(StartY, 4, Random, Placements);
+        if (TestEqual(TEXT("Known pattern obstacles per slot"), Placements.Num(), SpawnParameters.NumObstacles * 2))
+        {
+            const float PatternStride = Pattern.Length + SpawnParameters.SpacingBetweenObstacles;
+            for (int32 Slot = 0; Slot < SpawnParameters.NumObstacles; ++Slot)
+            {
+                const FObstaclePlacement& Front = Placements[Slot * 2];
+                const FObstaclePlacement& Back = Placements[Slot * 2 + 1];
+                TestEqual(TEXT("Pattern front Y"), Front.Y, StartY + Slot * PatternStride, 0.01f);
+                TestEqual(TEXT("Pattern front lane"), static_cast<int32>(Front.LaneIndex), 0);
+                TestEqual(TEXT("Pattern back Y"), Back.Y, StartY + Slot * PatternStride + 500.0f, 0.01f);
+                TestEqual(TEXT("Pattern back lane"), static_cast<int32>(Back.LaneIndex), 3);
+            }
+            TestEqual(TEXT("The next chunk starts after the last pattern"), EndY, StartY + SpawnParameters.NumObstacles * PatternStride, 0.01f);
+        }
+    }
+    return true;
+}
+
+#endif
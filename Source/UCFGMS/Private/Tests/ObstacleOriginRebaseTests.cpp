@@ -0,0 +1,165 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleTestWorld.h"
+#include "ObstacleOriginRebaseSubsystem.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    constexpr float PositionTolerance = 0.1f;
+
+    // Required groups have to hold something, or the test would pass without having looked at them
+    void TestShifted(FAutomationTestBase& Test, const TCHAR* What, const TArray<FVector>& Before, const TArray<FVector>& After, const FVector& Offset, bool bRequired)
+    {
+        if (bRequired && !Test.TestTrue(*FString::Printf(TEXT("%s to check"), What), Before.Num() > 0))
+        {
+            return;
+        }
+        if (!Test.TestEqual(*FString::Printf(TEXT("%s kept through the shift"), What), After.Num(), Before.Num()))
+        {
+            return;
+        }
+        for (int32 Index = 0; Index < Before.Num(); ++Index)
+        {
+            Test.TestEqual(*FString::Printf(TEXT("%s %d shifted with the origin"), What, Index), After[Index], Before[Index] + Offset, PositionTolerance);
+        }
+    }
+
+    struct FRequiredPositions
+    {
+        bool bActors = false;
+        bool bComponents = false;
+        bool bInstances = false;
+        bool bPending = false;
+        bool bGroundSnaps = false;
+        bool bEntities = false;
+    };
+
+    void TestAllShifted(FAutomationTestBase& Test, const TCHAR* Spawner, const FObstaclePositions& Before, const FObstaclePositions& After, const FVector& Offset, const FRequiredPositions& Required)
+    {
+        TestShifted(Test, *FString::Printf(TEXT("%s actor"), Spawner), Before.Actors, After.Actors, Offset, Required.bActors);
+        TestShifted(Test, *FString::Printf(TEXT("%s mesh component"), Spawner), Before.Components, After.Components, Offset, Required.bComponents);
+        TestShifted(Test, *FString::Printf(TEXT("%s instance"), Spawner), Before.Instances, After.Instances, Offset, Required.bInstances);
+        TestShifted(Test, *FString::Printf(TEXT("%s pending placement"), Spawner), Before.Pending, After.Pending, Offset, Required.bPending);
+        TestShifted(Test, *FString::Printf(TEXT("%s ground snap placement"), Spawner), Before.GroundSnaps, After.GroundSnaps, Offset, Required.bGroundSnaps);
+        TestShifted(Test, *FString::Printf(TEXT("%s entity"), Spawner), Before.Entities, After.Entities, Offset, Required.bEntities);
+    }
+
+    bool ContainsPosition(const TArray<FVector>& Positions, const FVector& Position)
+    {
+        return Positions.ContainsByPredicate([&Position](const FVector& Other)
+        {
+            return Other.Equals(Position, PositionTolerance);
+        });
+    }
+}
+
+// Moves the world origin while obstacles are spawned, pending, waiting on ground traces and stored as entities,
+// and checks that every one of them moved with it
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FObstacleOriginRebaseMidStreamTest, "UCFGMS.Obstacles.OriginRebase.MidStream", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FObstacleOriginRebaseMidStreamTest::RunTest(const FString& Parameters)
+{
+    constexpr int32 RebaseY = 25000;
+
+    FObstacleTestWorld TestWorld;
+    UObstacleOriginRebaseSubsystem* Rebase = TestWorld.GetWorld()->GetSubsystem<UObstacleOriginRebaseSubsystem>();
+    if (!TestNotNull(TEXT("Origin rebase subsystem"), Rebase))
+    {
+        return false;
+    }
+
+    const FObstacleSpawnParameters SpawnParameters = FObstacleTestWorld::MakeMixedParameters();
+    const TArray<FVector> LanePositions = { FVector(-300.0f, 0.0f, 0.0f), FVector(0.0f, 0.0f, 0.0f), FVector(300.0f, 0.0f, 0.0f) };
+    TArray<AActor*> SpawnedActors;
+
+    // Actors and the spawner's own mesh components, all spawned at once
+    AObstacleSpawner* ComponentSpawner = TestWorld.SpawnSpawner([](AObstacleSpawner& NewSpawner)
+    {
+        NewSpawner.RandomSeed = 1;
+        NewSpawner.bUseInstancedStaticMeshes = false;
+    });
+    ComponentSpawner->SpawnObstaclesBatch(SpawnParameters, LanePositions, SpawnedActors);
+
+    // Actors and instances
+    AObstacleSpawner* InstanceSpawner = TestWorld.SpawnSpawner([](AObstacleSpawner& NewSpawner)
+    {
+        NewSpawner.RandomSeed = 2;
+        NewSpawner.bUseInstancedStaticMeshes = true;
+    });
+    InstanceSpawner->SpawnObstaclesBatch(SpawnParameters, LanePositions, SpawnedActors);
+
+    // A stream with no spawn budget spawns one obstacle a frame, the rest of its chunk stays pending or, further
+    // out, entities
+    AObstacleSpawner* StreamSpawner = TestWorld.SpawnSpawner([](AObstacleSpawner& NewSpawner)
+    {
+        NewSpawner.RandomSeed = 3;
+        NewSpawner.bUseObstacleEntities = true;
+        NewSpawner.EntityPromotionDistance = 5000.0f;
+        NewSpawner.SpawnBudgetMs = 0.0f;
+        NewSpawner.SpawnLookaheadDistance = 0.0f;
+    });
+    StreamSpawner->StartChunkStream(LanePositions);
+    FObstacleSpawnerTestAccess::Step(*StreamSpawner, 0.0f);
+
+    // Nothing ticks the world, so the ground traces are never answered and the chunk waits for them
+    AObstacleSpawner* SnapSpawner = TestWorld.SpawnSpawner([](AObstacleSpawner& NewSpawner)
+    {
+        NewSpawner.RandomSeed = 4;
+        NewSpawner.bSnapObstaclesToGround = true;
+    });
+    SnapSpawner->StartChunkStream(LanePositions);
+    FObstacleSpawnerTestAccess::Step(*SnapSpawner, 0.0f);
+
+    const FObstaclePositions ComponentBefore = FObstacleSpawnerTestAccess::GatherPositions(*ComponentSpawner);
+    const FObstaclePositions InstanceBefore = FObstacleSpawnerTestAccess::GatherPositions(*InstanceSpawner);
+    const FObstaclePositions StreamBefore = FObstacleSpawnerTestAccess::GatherPositions(*StreamSpawner);
+    const FObstaclePositions SnapBefore = FObstacleSpawnerTestAccess::GatherPositions(*SnapSpawner);
+    const float StreamEndBefore = FObstacleSpawnerTestAccess::GetStreamEndY(*StreamSpawner);
+
+    if (!TestTrue(TEXT("Origin moved"), Rebase->RebaseOrigin(RebaseY)))
+    {
+        return false;
+    }
+    const FVector Offset(0.0f, -RebaseY, 0.0f);
+
+    FRequiredPositions ComponentRequired;
+    ComponentRequired.bActors = true;
+    ComponentRequired.bComponents = true;
+    TestAllShifted(*this, TEXT("Component spawner"), ComponentBefore, FObstacleSpawnerTestAccess::GatherPositions(*ComponentSpawner), Offset, ComponentRequired);
+
+    FRequiredPositions InstanceRequired;
+    InstanceRequired.bActors = true;
+    InstanceRequired.bInstances = true;
+    TestAllShifted(*this, TEXT("Instance spawner"), InstanceBefore, FObstacleSpawnerTestAccess::GatherPositions(*InstanceSpawner), Offset, InstanceRequired);
+
+    FRequiredPositions StreamRequired;
+    StreamRequired.bPending = true;
+    StreamRequired.bEntities = true;
+    TestAllShifted(*this, TEXT("Stream spawner"), StreamBefore, FObstacleSpawnerTestAccess::GatherPositions(*StreamSpawner), Offset, StreamRequired);
+    TestEqual(TEXT("Chunk stream end shifted with the origin"), FObstacleSpawnerTestAccess::GetStreamEndY(*StreamSpawner), StreamEndBefore + static_cast<float>(Offset.Y), PositionTolerance);
+
+    FRequiredPositions SnapRequired;
+    SnapRequired.bGroundSnaps = true;
+    TestAllShifted(*this, TEXT("Snap spawner"), SnapBefore, FObstacleSpawnerTestAccess::GatherPositions(*SnapSpawner), Offset, SnapRequired);
+
+    // The stream carries on in the new coordinates, what was pending before the shift spawns where it is now
+    StreamSpawner->SpawnBudgetMs = 1000.0f;
+    FObstacleSpawnerTestAccess::Step(*StreamSpawner, static_cast<float>(Offset.Y));
+    const FObstaclePositions StreamAfterSpawning = FObstacleSpawnerTestAccess::GatherPositions(*StreamSpawner);
+    for (const FVector& PendingPosition : StreamBefore.Pending)
+    {
+        const FVector Expected = PendingPosition + Offset;
+        TestTrue(*FString::Printf(TEXT("Pending obstacle spawned at %s"), *Expected.ToString()),
+            ContainsPosition(StreamAfterSpawning.Actors, Expected) || ContainsPosition(StreamAfterSpawning.Components, Expected) || ContainsPosition(StreamAfterSpawning.Instances, Expected));
+    }
+
+    StreamSpawner->StopChunkStream();
+    SnapSpawner->StopChunkStream();
+    return true;
+}
+
+#endif
@@ -0,0 +1,96 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ObstacleTestWorld.h"
+#include "ObstacleCountingMalloc.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace
+{
+    constexpr int32 NumWarmupBatches = 50;
+    constexpr int32 NumMeasuredBatches = 20;
+
+    // Spawns batches one after the other along the track, despawning behind each like the benchmark commandlet,
+    // and counts what the game thread allocates inside the spawn calls of the measured ones
+    template <typename FunctorType>
+    uint64 CountSpawnAllocations(AObstacleSpawner& Spawner, const FObstacleSpawnParameters& Parameters, FunctorType&& Spawn)
+    {
+        TArray<FVector> LanePositions = { FVector(-300.0f, 0.0f, 0.0f), FVector(0.0f, 0.0f, 0.0f), FVector(300.0f, 0.0f, 0.0f) };
+
+        // Never deleted, another thread may still be inside it when it is taken out
+        FObstacleCountingMalloc* CountingMalloc = new FObstacleCountingMalloc(GMalloc);
+        GMalloc = CountingMalloc;
+
+        uint64 NumAllocations = 0;
+        float BatchY = 0.0f;
+        for (int32 Batch = 0; Batch < NumWarmupBatches + NumMeasuredBatches; ++Batch)
+        {
+            for (FVector& LanePosition : LanePositions)
+            {
+                LanePosition.Y = BatchY;
+            }
+
+            const uint64 AllocationsBefore = CountingMalloc->GetNumAllocations();
+            Spawn(LanePositions);
+            if (Batch >= NumWarmupBatches)
+            {
+                NumAllocations += CountingMalloc->GetNumAllocations() - AllocationsBefore;
+            }
+
+            FObstacleSpawnerTestAccess::DespawnBehind(Spawner, BatchY);
+            BatchY = FObstacleSpawnerTestAccess::GetNextBatchY(Spawner, Parameters, BatchY);
+        }
+
+        GMalloc = CountingMalloc->GetUsedMalloc();
+        return NumAllocations;
+    }
+}
+
+// Once pools, recyclers and scratch arrays are warm, spawning a batch into a reused array must not touch the heap
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FObstacleSpawnerBatchAllocationTest, "UCFGMS.Obstacles.Spawner.BatchAllocations", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FObstacleSpawnerBatchAllocationTest::RunTest(const FString& Parameters)
+{
+    FObstacleTestWorld TestWorld;
+    const FObstacleSpawnParameters SpawnParameters = FObstacleTestWorld::MakeMixedParameters();
+    AObstacleSpawner* Spawner = TestWorld.SpawnSpawner([](AObstacleSpawner& NewSpawner)
+    {
+        NewSpawner.RandomSeed = 1337;
+    });
+
+    TArray<AActor*> SpawnedActors;
+    const uint64 NumAllocations = CountSpawnAllocations(*Spawner, SpawnParameters, [Spawner, &SpawnParameters, &SpawnedActors](const TArray<FVector>& LanePositions)
+    {
+        SpawnedActors.Reset();
+        Spawner->SpawnObstaclesBatch(SpawnParameters, LanePositions, SpawnedActors);
+    });
+
+    TestEqual(TEXT("Game thread allocations in warm SpawnObstaclesBatch calls"), static_cast<int64>(NumAllocations), int64(0));
+    return true;
+}
+
+// SpawnObstacles hands Blueprint an array of its own, that copy is all it may allocate
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FObstacleSpawnerReturnAllocationTest, "UCFGMS.Obstacles.Spawner.ReturnedArrayAllocations", EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FObstacleSpawnerReturnAllocationTest::RunTest(const FString& Parameters)
+{
+    FObstacleTestWorld TestWorld;
+    const FObstacleSpawnParameters SpawnParameters = FObstacleTestWorld::MakeMixedParameters();
+    AObstacleSpawner* Spawner = TestWorld.SpawnSpawner([](AObstacleSpawner& NewSpawner)
+    {
+        NewSpawner.RandomSeed = 1337;
+    });
+
+    const uint64 NumAllocations = CountSpawnAllocations(*Spawner, SpawnParameters, [Spawner, &SpawnParameters](const TArray<FVector>& LanePositions)
+    {
+        // Destroyed inside the counted scope, freeing is not counted
+        TArray<AActor*> SpawnedActors = Spawner->SpawnObstacles(SpawnParameters, LanePositions);
+    });
+
+    TestTrue(FString::Printf(TEXT("%llu game thread allocations in %d warm SpawnObstacles calls, at most one each"), NumAllocations, NumMeasuredBatches), NumAllocations <= NumMeasuredBatches);
+    return true;
+}
+
+#endif
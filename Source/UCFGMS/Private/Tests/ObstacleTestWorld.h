@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "ObstacleSpawner.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+
+// A game world that has begun play, for tests that need the spawner's BeginPlay and its subsystems.
+// Nothing ticks it, tests drive the spawner through FObstacleSpawnerTestAccess
+class FObstacleTestWorld
+{
+public:
+    FObstacleTestWorld()
+    {
+        World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("ObstacleTestWorld"));
+        FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+        WorldContext.SetCurrentWorld(World);
+        World->InitializeActorsForPlay(FURL());
+        World->BeginPlay();
+        // No game mode starts the match here, this is the call its game state would make
+        World->GetWorldSettings()->NotifyBeginPlay();
+    }
+
+    ~FObstacleTestWorld()
+    {
+        GEngine->DestroyWorldContext(World);
+        World->DestroyWorld(false);
+    }
+
+    UWorld* GetWorld() const { return World; }
+
+    // Configure runs on the spawner before its BeginPlay, so seeds and parameters are in place when it reads them
+    template <typename FunctorType>
+    AObstacleSpawner* SpawnSpawner(FunctorType&& Configure) const
+    {
+        AObstacleSpawner* Spawner = World->SpawnActorDeferred<AObstacleSpawner>(AObstacleSpawner::StaticClass(), FTransform::Identity);
+        Configure(*Spawner);
+        Spawner->FinishSpawning(FTransform::Identity);
+        return Spawner;
+    }
+
+    // Every representation the spawner has: mesh components, an instanced mesh, pooled actors with planes
+    static FObstacleSpawnParameters MakeMixedParameters()
+    {
+        FObstacleSpawnParameters Parameters;
+        Parameters.NumObstacles = 12;
+        Parameters.SpacingBetweenObstacles = 1000.0f;
+
+        FObstacleSpawnInfo& Cube = Parameters.ObstacleTypes.AddDefaulted_GetRef();
+        Cube.StaticMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+        Cube.SpawnWeight = 2.0f;
+
+        FObstacleSpawnInfo& Blocker = Parameters.ObstacleTypes.AddDefaulted_GetRef();
+        Blocker.ObstacleActorClass = AStaticMeshActor::StaticClass();
+        Blocker.PlaneMesh = AStaticMeshActor::StaticClass();
+        Blocker.PlaneSpawnProbability = 0.5f;
+        Blocker.PoolPrewarmCount = 8;
+
+        FObstacleSpawnInfo& Sphere = Parameters.ObstacleTypes.AddDefaulted_GetRef();
+        Sphere.StaticMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Sphere.Sphere"));
+        return Parameters;
+    }
+
+private:
+    UWorld* World = nullptr;
+};
+
+// World positions of everything a spawner keeps, grouped by how it keeps them. Placements not spawned yet are at
+// their lane position and planned Y
+struct FObstaclePositions
+{
+    TArray<FVector> Actors;
+    TArray<FVector> Components;
+    TArray<FVector> Instances;
+    TArray<FVector> Pending;
+    TArray<FVector> GroundSnaps;
+    TArray<FVector> Entities;
+};
+
+// Reaches into the spawner for tests, the same way the benchmark commandlet does
+struct FObstacleSpawnerTestAccess
+{
+    // One spawner frame with the player at PlayerY. Waits first for the chunk plan in flight, so a test step
+    // does not depend on how fast the worker thread was
+    static void Step(AObstacleSpawner& Spawner, float PlayerY)
+    {
+        if (Spawner.CompletedChunkPlans.IsValid())
+        {
+            const double TimeoutTime = FPlatformTime::Seconds() + 5.0;
+            while (!Spawner.CompletedChunkPlans->Peek() && FPlatformTime::Seconds() < TimeoutTime)
+            {
+                FPlatformProcess::Sleep(0.0f);
+            }
+        }
+        Spawner.UpdateObstacles(true, PlayerY);
+    }
+
+    static void UpdateWithoutPlayer(AObstacleSpawner& Spawner) { Spawner.UpdateObstacles(false, 0.0f); }
+
+    // What the benchmark commandlet does once the runner reached Y, without the rest of a frame
+    static void DespawnBehind(AObstacleSpawner& Spawner, float Y) { Spawner.DespawnObstaclesBehind(Y); }
+
+    // Where SpawnObstaclesBatch calls that follow each other along the track start the next one
+    static float GetNextBatchY(const AObstacleSpawner& Spawner, const FObstacleSpawnParameters& Parameters, float BatchY)
+    {
+        return Spawner.TrackedObstacles.Num() > 0 ? Spawner.TrackedObstacles.Last().Y + Parameters.SpacingBetweenObstacles : BatchY + Parameters.NumObstacles * Parameters.SpacingBetweenObstacles;
+    }
+
+    static int32 GetNumActiveChunks(const AObstacleSpawner& Spawner) { return Spawner.NumActiveChunks; }
+    static int32 GetNumLaneEntries(const AObstacleSpawner& Spawner) { return Spawner.LaneIndex.Num(); }
+    static int32 GetNumPendingBatches(const AObstacleSpawner& Spawner) { return Spawner.PendingBatches.Num(); }
+    static int32 GetNumParkedComponents(const AObstacleSpawner& Spawner) { return Spawner.ComponentRecycler.GetNumParked(); }
+    static UObstaclePoolSubsystem* GetPool(const AObstacleSpawner& Spawner) { return Spawner.ObstaclePool; }
+
+    // Highest Y the chunk stream has planned up to, the simulated runner follows it
+    static float GetStreamEndY(const AObstacleSpawner& Spawner)
+    {
+        float EndY = TNumericLimits<float>::Lowest();
+        for (int32 Index = 0; Index < Spawner.NumActiveChunks; ++Index)
+        {
+            EndY = FMath::Max(EndY, Spawner.ChunkRing[(Spawner.OldestChunkSlot + Index) % Spawner.ChunkRing.Num()].EndY);
+        }
+        return EndY;
+    }
+
+    static float GetOldestChunkEndY(const AObstacleSpawner& Spawner)
+    {
+        return Spawner.NumActiveChunks > 0 ? Spawner.ChunkRing[Spawner.OldestChunkSlot].EndY : TNumericLimits<float>::Lowest();
+    }
+
+    // In a fixed order, so positions gathered before and after something that keeps the order line up
+    static FObstaclePositions GatherPositions(const AObstacleSpawner& Spawner)
+    {
+        FObstaclePositions Positions;
+        const auto AddTracked = [&Spawner, &Positions](const FTrackedObstacle& Obstacle)
+        {
+            FTransform InstanceTransform;
+            if (Obstacle.Actor)
+            {
+                Positions.Actors.Add(Obstacle.Actor->GetActorLocation());
+            }
+            else if (Obstacle.Component)
+            {
+                Positions.Components.Add(Obstacle.Component->GetComponentLocation());
+            }
+            else if (Spawner.InstanceBatcher.GetInstanceTransform(Obstacle.Instance.Mesh, Obstacle.Instance.InstanceIndex, InstanceTransform))
+            {
+                Positions.Instances.Add(InstanceTransform.GetLocation());
+            }
+        };
+        for (const FTrackedObstacle& Obstacle : Spawner.TrackedObstacles)
+        {
+            AddTracked(Obstacle);
+        }
+        for (const FTrackChunk& Chunk : Spawner.ChunkRing)
+        {
+            for (const FTrackedObstacle& Obstacle : Chunk.Obstacles)
+            {
+                AddTracked(Obstacle);
+            }
+        }
+
+        for (const FPendingObstacleBatch& Batch : Spawner.PendingBatches)
+        {
+            for (int32 Index = Batch.NextIndex; Index < Batch.Placements.Num(); ++Index)
+            {
+                Positions.Pending.Add(GetPlannedPosition(Batch.Placements[Index], Batch.LanePositions));
+            }
+        }
+        for (const FGroundSnapBatch& Batch : Spawner.GroundSnapBatches)
+        {
+            for (const FObstaclePlacement& Placement : Batch.Placements)
+            {
+                Positions.GroundSnaps.Add(GetPlannedPosition(Placement, Batch.LanePositions));
+            }
+        }
+        for (int32 Index = 0; Index < Spawner.ObstacleEntities.Num(); ++Index)
+        {
+            const FObstacleEntitySource& Source = Spawner.EntitySources[Spawner.ObstacleEntities.GetSource(Index)];
+            Positions.Entities.Add(GetPlannedPosition(Spawner.ObstacleEntities.GetPlacement(Index), Source.LanePositions));
+        }
+        return Positions;
+    }
+
+    static FVector GetPlannedPosition(const FObstaclePlacement& Placement, const TArray<FVector>& LanePositions)
+    {
+        const FVector& LanePosition = LanePositions[Placement.LaneIndex];
+        return FVector(LanePosition.X, Placement.Y, LanePosition.Z + Placement.GroundOffsetZ);
+    }
+};
+
+#endif
@@ -4,27 +4,65 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "MoverSplineTable.h"
+#include "PooledObstacle.h"
 #include "Mover.generated.h"
 
 UCLASS()
-class UCFGMS_API AMover : public AActor
+class UCFGMS_API AMover : public AActor, public IPooledObstacle
 {
 	GENERATED_BODY()
 	
 public:	
 	// Sets default values for this actor's properties
 	AMover();
-	UPROPERTY(EditAnywhere,BlueprintReadWrite)
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,BlueprintSetter=SetMoving)
 	bool mm=false;
+	// Let UMoverSubsystem move this actor together with all other movers instead of ticking it
+	UPROPERTY(EditAnywhere,BlueprintReadWrite)
+	bool bBatchedMovement=true;
+
+	// Follow the spline on this actor instead of moving by moveoffset, the whole spline takes movetime
+	UPROPERTY(EditAnywhere,BlueprintReadWrite)
+	TObjectPtr<AActor> splinepath;
+	UPROPERTY(EditAnywhere,BlueprintReadWrite)
+	bool bOrientToSpline=true;
+	// Distance between the precomputed spline samples, smaller follows tight curves more closely
+	UPROPERTY(EditAnywhere,BlueprintReadWrite,meta=(ClampMin="1"))
+	float splinesamplespacing=50;
+
+	// Samples splinepath again, call after moving or editing the spline at runtime
+	UFUNCTION(BlueprintCallable)
+	void RebuildSplinePath();
+
+	// Starts or stops the move to origniallocation+moveoffset, or along splinepath. C++ has to call this rather than write mm, or the mover stays asleep
+	UFUNCTION(BlueprintSetter)
+	void SetMoving(bool bMoving);
+
+	// Where the current move puts the mover at Time (world seconds), without needing a tick
+	UFUNCTION(BlueprintPure)
+	FVector GetLocationAtTime(double Time) const;
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
+	virtual void ApplyWorldOffset(const FVector& InOffset, bool bWorldShift) override;
+
+	// A reused mover starts over from where the pool put it, with mm as the class sets it
+	virtual void OnAcquiredFromPool_Implementation() override;
+	// Parked movers stop, so UMoverSubsystem does not move hidden actors
+	virtual void OnParkedInPool_Implementation() override;
 private:
+	void StartMove();
+	void Sleep();
+	void BuildSplinePath(bool bRebuild);
+	float GetPathDistanceAtTime(double Time) const;
+
 	UPROPERTY(EditAnywhere)
 	FVector moveoffset;
 	UPROPERTY(EditAnywhere)
@@ -32,4 +70,19 @@ private:
 	
 
 	FVector origniallocation;
+
+	// The current move, a straight line from MoveStartLocation to the target taking MoveDuration
+	FVector MoveStartLocation;
+	double MoveStartTime=0.0;
+	double MoveDuration=0.0;
+
+	// Shared with every mover on the same spline, null when moving by moveoffset
+	TSharedPtr<const FMoverSplineTable> SplineTable;
+	// How far along the spline the current move starts, and where a stopped mover resumes
+	float MoveStartDistance=0.0f;
+
+	// Slot in UMoverSubsystem while it moves this mover
+	int32 MoverSlot=INDEX_NONE;
+
+	friend class UMoverSubsystem;
 };
@@ -0,0 +1,50 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class USplineComponent;
+
+// A spline sampled at equal distances along its length when it is built, so a distance maps to a location
+// with one index and one lerp instead of the spline's own search over its reparameterization table
+struct UCFGMS_API FMoverSplineTable
+{
+	// Samples the spline in world space, moving the spline afterwards needs a rebuild
+	void Build(const USplineComponent& Spline, float InRequestedSpacing);
+
+	// Follows the spline when the world origin moves under it
+	void ApplyWorldOffset(const FVector& Offset);
+
+	FVector GetLocationAtDistance(float Distance) const
+	{
+		int32 Index;
+		const float Fraction = GetSample(Distance, Index);
+		return FMath::Lerp(Locations[Index], Locations[Index + 1], Fraction);
+	}
+
+	FQuat GetRotationAtDistance(float Distance) const
+	{
+		int32 Index;
+		const float Fraction = GetSample(Distance, Index);
+		return FQuat::Slerp(Rotations[Index], Rotations[Index + 1], Fraction);
+	}
+
+	float GetLength() const { return Length; }
+	float GetRequestedSpacing() const { return RequestedSpacing; }
+
+private:
+	float GetSample(float Distance, int32& OutIndex) const
+	{
+		const float Sample = FMath::Clamp(Distance * InvSampleSpacing, 0.0f, static_cast<float>(Locations.Num() - 1));
+		OutIndex = FMath::Min(static_cast<int32>(Sample), Locations.Num() - 2);
+		return Sample - OutIndex;
+	}
+
+	// Always at least two samples, the first at the start and the last exactly at the end of the spline
+	TArray<FVector> Locations;
+	TArray<FQuat> Rotations;
+	float InvSampleSpacing = 1.0f;
+	float RequestedSpacing = 0.0f;
+	float Length = 0.0f;
+};
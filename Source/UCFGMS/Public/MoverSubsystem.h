@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "MoverSplineTable.h"
+#include "MoverSubsystem.generated.h"
+
+class AMover;
+class USplineComponent;
+
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnMoverMoved, AMover*);
+
+// Moves every awake AMover in one pass per frame, so movers need no tick of their own.
+// Only movers that are on their way are kept, as parallel arrays indexed by the mover's slot.
+UCLASS()
+class UCFGMS_API UMoverSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Picks up the mover's current move, it is dropped again once it reaches its target.
+	// Calls made from inside Tick, e.g. by an overlap event, are applied once the pass is done
+	void Wake(AMover* Mover);
+	void Sleep(AMover* Mover);
+
+	// Arc-length table for Spline, built once and shared by every mover on it
+	TSharedRef<const FMoverSplineTable> GetSplineTable(const USplineComponent& Spline, float SampleSpacing, bool bRebuild);
+
+	int32 GetNumAwakeMovers() const { return Movers.Num(); }
+
+	// Fires for every mover moved this frame, by this subsystem or by the mover's own tick
+	FOnMoverMoved OnMoverMoved;
+
+private:
+	void RemoveSlot(int32 Slot);
+	bool HasPendingRequest(const AMover* Mover) const;
+	void HandleWorldOriginOffset(UWorld* InWorld, FIntVector SrcOrigin, FIntVector DstOrigin);
+
+	UPROPERTY()
+	TArray<TObjectPtr<AMover>> Movers;
+
+	TArray<FVector> Starts;
+	TArray<FVector> Targets;
+	TArray<double> StartTimes;
+	TArray<double> Durations;
+
+	// Set for movers following a spline, those go from PathStartDistances to the end of the path instead of Starts to Targets
+	TArray<const FMoverSplineTable*> Paths;
+	TArray<float> PathStartDistances;
+	TArray<bool> OrientToPath;
+
+	// Movers far from the player move in steps at their tick LOD interval, see UObstacleTickLODSubsystem
+	TArray<double> NextUpdateTimes;
+
+	// Mutable here so an origin shift can move every shared table once
+	TMap<TObjectKey<USplineComponent>, TSharedRef<FMoverSplineTable>> SplineTables;
+
+	FDelegateHandle WorldOriginOffsetHandle;
+
+	// Set while Tick walks the arrays, Wake and Sleep queue up in PendingRequests instead of moving slots around
+	bool bTicking = false;
+
+	// In call order, true for a wake
+	TArray<TPair<TWeakObjectPtr<AMover>, bool>> PendingRequests;
+
+	// Per-frame scratch
+	TArray<FVector> Positions;
+	TArray<float> PathDistances;
+	TArray<int32> MovedSlots;
+	TArray<int32> ArrivedSlots;
+};
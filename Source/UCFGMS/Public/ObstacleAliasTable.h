@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Vose's alias method: scale the weights so they average 1, then pair every column below 1 with one above it.
+// A pick takes column i with probability OutProbability[i], otherwise OutAlias[i]. Negative weights count as 0,
+// and without any positive weight every column is equally likely
+template <typename IndexType, typename ProbabilityAllocator, typename AliasAllocator>
+void BuildObstacleAliasTable(TArrayView<const float> Weights, TArray<float, ProbabilityAllocator>& OutProbability, TArray<IndexType, AliasAllocator>& OutAlias)
+{
+    const int32 NumColumns = Weights.Num();
+    OutProbability.SetNumUninitialized(NumColumns);
+    OutAlias.SetNumUninitialized(NumColumns);
+
+    double TotalWeight = 0.0;
+    for (const float Weight : Weights)
+    {
+        TotalWeight += FMath::Max(static_cast<double>(Weight), 0.0);
+    }
+
+    TArray<int32, TInlineAllocator<32>> Small;
+    TArray<int32, TInlineAllocator<32>> Large;
+    TArray<double, TInlineAllocator<32>> Scaled;
+    Scaled.SetNumUninitialized(NumColumns);
+    for (int32 Column = 0; Column < NumColumns; ++Column)
+    {
+        Scaled[Column] = TotalWeight > 0.0 ? FMath::Max(static_cast<double>(Weights[Column]), 0.0) * NumColumns / TotalWeight : 1.0;
+        OutAlias[Column] = static_cast<IndexType>(Column);
+        (Scaled[Column] < 1.0 ? Small : Large).Add(Column);
+    }
+
+    while (Small.Num() > 0 && Large.Num() > 0)
+    {
+        const int32 Less = Small.Pop(false);
+        const int32 More = Large.Pop(false);
+        OutProbability[Less] = static_cast<float>(Scaled[Less]);
+        OutAlias[Less] = static_cast<IndexType>(More);
+        Scaled[More] = (Scaled[More] + Scaled[Less]) - 1.0;
+        (Scaled[More] < 1.0 ? Small : Large).Add(More);
+    }
+
+    // Whatever is left is 1 up to rounding
+    for (const int32 Column : Large)
+    {
+        OutProbability[Column] = 1.0f;
+    }
+    for (const int32 Column : Small)
+    {
+        OutProbability[Column] = 1.0f;
+    }
+}
@@ -0,0 +1,44 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/SoftObjectPath.h"
+
+struct FObstacleSpawnInfo;
+struct FStreamableHandle;
+
+// Streams the soft-referenced assets of obstacle types in ahead of use and lets go of types that have not been used for a while
+class UCFGMS_API FObstacleAssetPrefetcher
+{
+public:
+    ~FObstacleAssetPrefetcher();
+
+    // Starts async loads for the soft references of SpawnInfo that are not requested yet
+    void Prefetch(const FObstacleSpawnInfo& SpawnInfo, double CurrentTime);
+
+    // True when every soft reference of SpawnInfo can be resolved without loading
+    bool IsLoaded(const FObstacleSpawnInfo& SpawnInfo) const;
+
+    // Loads whatever prefetching has not finished yet. This blocks, so every call is counted as a prefetch miss
+    void LoadMissing(const FObstacleSpawnInfo& SpawnInfo, double CurrentTime);
+
+    // Drops the handles of assets not prefetched or loaded for MaxIdleSeconds and appends their paths to OutReleased.
+    // The assets only unload once the caller has also let go of whatever it parked for them
+    void ReleaseIdle(double CurrentTime, double MaxIdleSeconds, TArray<FSoftObjectPath>& OutReleased);
+
+    void ReleaseAll();
+
+    int32 GetNumRequested() const { return Requests.Num(); }
+
+private:
+    struct FPrefetchRequest
+    {
+        TSharedPtr<FStreamableHandle> Handle;
+        double LastUsedTime = 0.0;
+    };
+
+    void Request(const FSoftObjectPath& Path, double CurrentTime);
+
+    TMap<FSoftObjectPath, FPrefetchRequest> Requests;
+};
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineTypes.h"
+#include "ObstacleComponentRecycler.generated.h"
+
+class UPrimitiveComponent;
+class USkeletalMesh;
+class USkeletalMeshComponent;
+class UStaticMesh;
+class UStaticMeshComponent;
+
+USTRUCT()
+struct FParkedObstacleComponents
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TArray<TObjectPtr<UPrimitiveComponent>> Components;
+
+    // Collision the components had while in use, restored when they come out of the park
+    TEnumAsByte<ECollisionEnabled::Type> ActiveCollision = ECollisionEnabled::QueryAndPhysics;
+};
+
+// Keeps the registered mesh components of obstacles parked per mesh asset, so reusing one only costs a transform change
+USTRUCT()
+struct UCFGMS_API FObstacleComponentRecycler
+{
+    GENERATED_BODY()
+
+    // Returns a registered component showing Mesh at Transform, owned by Owner
+    UStaticMeshComponent* AcquireStaticMesh(AActor* Owner, UStaticMesh* Mesh, const FTransform& Transform);
+    USkeletalMeshComponent* AcquireSkeletalMesh(AActor* Owner, USkeletalMesh* Mesh, const FTransform& Transform);
+
+    // Hides the component and turns its collision off, it stays registered
+    void Release(UPrimitiveComponent* Component);
+
+    // Destroys the components parked for MeshAsset, so the recycler no longer keeps the asset loaded
+    void DropParked(UObject* MeshAsset);
+
+    int32 GetNumParked() const { return NumParked; }
+
+private:
+    UPrimitiveComponent* Unpark(UObject* MeshAsset, const FTransform& Transform);
+
+    UPROPERTY()
+    TMap<TObjectPtr<UObject>, FParkedObstacleComponents> Parked;
+
+    int32 NumParked = 0;
+};
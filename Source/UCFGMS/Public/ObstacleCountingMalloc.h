@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include <atomic>
+
+// Counts the heap allocations of the thread that created it on their way to the real allocator.
+// Installed only around measured work, by the benchmark commandlet and the allocation tests
+class FObstacleCountingMalloc final : public FMalloc
+{
+public:
+    explicit FObstacleCountingMalloc(FMalloc* InUsedMalloc)
+        : UsedMalloc(InUsedMalloc)
+        , CountedThreadId(FPlatformTLS::GetCurrentThreadId())
+    {
+    }
+
+    virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+    {
+        CountAllocation(Count);
+        return UsedMalloc->Malloc(Count, Alignment);
+    }
+
+    virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+    {
+        CountAllocation(Count);
+        return UsedMalloc->TryMalloc(Count, Alignment);
+    }
+
+    virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+    {
+        CountAllocation(Count);
+        return UsedMalloc->Realloc(Original, Count, Alignment);
+    }
+
+    virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+    {
+        CountAllocation(Count);
+        return UsedMalloc->TryRealloc(Original, Count, Alignment);
+    }
+
+    virtual void Free(void* Original) override { UsedMalloc->Free(Original); }
+    virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return UsedMalloc->QuantizeSize(Count, Alignment); }
+    virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return UsedMalloc->GetAllocationSize(Original, SizeOut); }
+    virtual void Trim(bool bTrimThreadCaches) override { UsedMalloc->Trim(bTrimThreadCaches); }
+    virtual void SetupTLSCachesOnCurrentThread() override { UsedMalloc->SetupTLSCachesOnCurrentThread(); }
+    virtual void ClearAndDisableTLSCachesOnCurrentThread() override { UsedMalloc->ClearAndDisableTLSCachesOnCurrentThread(); }
+    virtual void UpdateStats() override { UsedMalloc->UpdateStats(); }
+    virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { UsedMalloc->GetAllocatorStats(OutStats); }
+    virtual void DumpAllocatorStats(FOutputDevice& Ar) override { UsedMalloc->DumpAllocatorStats(Ar); }
+    virtual bool IsInternallyThreadSafe() const override { return UsedMalloc->IsInternallyThreadSafe(); }
+    virtual bool ValidateHeap() override { return UsedMalloc->ValidateHeap(); }
+    virtual const TCHAR* GetDescriptiveName() override { return UsedMalloc->GetDescriptiveName(); }
+
+    FMalloc* GetUsedMalloc() const { return UsedMalloc; }
+    uint64 GetNumAllocations() const { return NumAllocations.load(std::memory_order_relaxed); }
+    uint64 GetAllocatedBytes() const { return AllocatedBytes.load(std::memory_order_relaxed); }
+
+private:
+    void CountAllocation(SIZE_T Count)
+    {
+        if (FPlatformTLS::GetCurrentThreadId() != CountedThreadId)
+        {
+            return;
+        }
+        NumAllocations.fetch_add(1, std::memory_order_relaxed);
+        AllocatedBytes.fetch_add(Count, std::memory_order_relaxed);
+    }
+
+    FMalloc* UsedMalloc;
+    const uint32 CountedThreadId;
+    std::atomic<uint64> NumAllocations{ 0 };
+    std::atomic<uint64> AllocatedBytes{ 0 };
+};
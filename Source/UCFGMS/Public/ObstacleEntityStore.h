@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ObstacleLayoutPlanner.h"
+
+// Obstacles planned too far ahead to need an actor yet. Each one is a handful of bytes spread over one array per
+// fragment, kept sorted by Y, so finding the ones the player has come close to only reads the front of the Y array.
+// Entities have no collision, rendering or lane index entry until they are promoted
+class UCFGMS_API FObstacleEntityStore
+{
+public:
+    // Source is whatever the caller needs to resolve the entity later, e.g. the parameters and lanes it was planned with
+    void Add(const FObstaclePlacement& Placement, int32 Source);
+
+    int32 Num() const { return Y.Num(); }
+
+    // Entities are sorted by Y, so the ones up to MaxY are the first NumUpTo(MaxY)
+    int32 NumUpTo(float MaxY) const;
+
+    FObstaclePlacement GetPlacement(int32 Index) const;
+    int32 GetSource(int32 Index) const { return Sources[Index]; }
+
+    // Drops the first Count entities, once they have been promoted
+    void RemoveFront(int32 Count);
+
+    // Drops every entity of Source, returns how many there were
+    int32 RemoveSource(int32 Source);
+
+    // Moves every entity by DeltaY, the order stays the same
+    void ShiftAll(float DeltaY);
+
+    void Reset();
+
+private:
+    static constexpr uint8 SpawnPlaneFlag = 1;
+
+    TArray<float> Y;
+    TArray<float> GroundOffsetZ;
+    TArray<uint16> TypeIndices;
+    TArray<uint8> LaneIndices;
+    TArray<uint8> Flags;
+    TArray<int32> Sources;
+};
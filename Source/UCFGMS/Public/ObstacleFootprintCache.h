@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/ObjectKey.h"
+#include "ObstacleFootprintCache.generated.h"
+
+struct FObstacleSpawnInfo;
+
+// Local bounds of obstacle meshes and actor classes, computed once per asset
+USTRUCT()
+struct UCFGMS_API FObstacleFootprintCache
+{
+    GENERATED_BODY()
+
+    // Bounds of a static mesh, skeletal mesh or actor class in its own space
+    FBox GetLocalBounds(UObject* Asset);
+
+    // Bounds of what SpawnInfo spawns relative to its spawn position, with its rotation, scale and location offset applied.
+    // Planes are left out, they fly above the track. Invalid while none of its assets are loaded
+    FBox GetFootprint(const FObstacleSpawnInfo& SpawnInfo);
+
+    // One footprint per obstacle type, in the order of ObstacleTypes
+    void GetFootprints(const TArray<FObstacleSpawnInfo>& ObstacleTypes, TArray<FBox>& OutFootprints);
+
+private:
+    // Weak keys, measuring an asset must not keep it loaded once the prefetcher lets go of it
+    TMap<TObjectKey<UObject>, FBox> Bounds;
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ObstacleInstanceBatcher.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+// One instance handed out by FObstacleInstanceBatcher, the mesh is kept alive by the batcher
+struct FObstacleInstanceHandle
+{
+    UStaticMesh* Mesh = nullptr;
+    int32 InstanceIndex = INDEX_NONE;
+};
+
+USTRUCT()
+struct FObstacleInstanceBatch
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    TObjectPtr<UInstancedStaticMeshComponent> Component;
+
+    // Zero-scaled instances waiting to be reused, removing them would shift the indices of every later instance
+    TArray<int32> FreeInstances;
+};
+
+// Draws every obstacle that shares a static mesh through one instanced component instead of one primitive per obstacle
+USTRUCT()
+struct UCFGMS_API FObstacleInstanceBatcher
+{
+    GENERATED_BODY()
+
+    // Places an instance of Mesh at Transform and returns its index in the mesh's batch
+    int32 AddInstance(AActor* Owner, UStaticMesh* Mesh, const FTransform& Transform);
+
+    // Hides the instance and removes its collision body, the slot is reused by the next AddInstance for Mesh
+    void RemoveInstance(UStaticMesh* Mesh, int32 InstanceIndex);
+
+    // Destroys the batch of Mesh once none of its instances are in use, so the batcher no longer keeps Mesh loaded
+    void DropIdleBatch(UStaticMesh* Mesh);
+
+    // World transform of a live instance, false if Mesh has no batch or the index is out of range
+    bool GetInstanceTransform(UStaticMesh* Mesh, int32 InstanceIndex, FTransform& OutTransform) const;
+
+    int32 GetNumBatches() const { return Batches.Num(); }
+    int32 GetNumLiveInstances() const { return NumLiveInstances; }
+
+private:
+    UPROPERTY()
+    TMap<TObjectPtr<UStaticMesh>, FObstacleInstanceBatch> Batches;
+
+    int32 NumLiveInstances = 0;
+};
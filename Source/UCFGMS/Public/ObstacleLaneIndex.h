@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ObstacleLaneIndex.generated.h"
+
+class UPrimitiveComponent;
+
+// A live obstacle as the lane index reports it
+USTRUCT(BlueprintType)
+struct FLaneObstacle
+{
+    GENERATED_BODY()
+
+    // Set for actor obstacles
+    UPROPERTY(BlueprintReadOnly, Category = "Obstacles|Lanes")
+    TWeakObjectPtr<AActor> Actor;
+
+    // Set for mesh component obstacles, instanced obstacles have neither
+    UPROPERTY(BlueprintReadOnly, Category = "Obstacles|Lanes")
+    TWeakObjectPtr<UPrimitiveComponent> Component;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Obstacles|Lanes")
+    int32 Lane = 0;
+
+    // Extent along the track
+    UPROPERTY(BlueprintReadOnly, Category = "Obstacles|Lanes")
+    float MinY = 0.0f;
+
+    UPROPERTY(BlueprintReadOnly, Category = "Obstacles|Lanes")
+    float MaxY = 0.0f;
+
+    int32 Id = INDEX_NONE;
+};
+
+// Live obstacles of every lane sorted by MinY, so "next obstacle in lane L after Y" is a binary search
+class UCFGMS_API FObstacleLaneIndex
+{
+public:
+    // Returns the id to move or remove the obstacle with
+    int32 Add(const FLaneObstacle& Obstacle);
+    void Remove(int32 Id);
+
+    // Call when an obstacle moved along the track
+    void Move(int32 Id, float MinY, float MaxY);
+
+    // Moves every obstacle by DeltaY, the order along the track stays the same
+    void ShiftAll(float DeltaY);
+
+    // First obstacle in Lane starting after Y
+    const FLaneObstacle* FindNext(int32 Lane, float Y) const;
+
+    // Every obstacle in Lane overlapping [MinY, MaxY], in track order
+    void FindInRange(int32 Lane, float MinY, float MaxY, TArray<FLaneObstacle>& OutObstacles) const;
+
+    int32 Num() const { return Locations.Num(); }
+
+private:
+    // Removed entries stay in Obstacles with an Id of INDEX_NONE until enough of them pile up to compact,
+    // so removing from the front of a lane does not shift the whole lane every time
+    struct FLaneEntries
+    {
+        TArray<FLaneObstacle> Obstacles;
+        int32 NumRemoved = 0;
+        // Longest live obstacle, a range query has to look back this far for obstacles starting before it
+        float MaxLength = 0.0f;
+        // Live obstacles as long as MaxLength, it is only recomputed when the last of them goes
+        int32 NumAtMaxLength = 0;
+    };
+
+    // Where an id lives, enough to binary search its entry
+    struct FLocation
+    {
+        int32 Lane = 0;
+        float MinY = 0.0f;
+    };
+
+    int32 FindEntryIndex(const FLocation& Location, int32 Id) const;
+    static void AddLength(FLaneEntries& Entries, float Length);
+    static void RemoveLength(FLaneEntries& Entries, float Length);
+    static void RemoveEntry(FLaneEntries& Entries, int32 EntryIndex);
+
+    TArray<FLaneEntries> Lanes;
+    TSparseArray<FLocation> Locations;
+};
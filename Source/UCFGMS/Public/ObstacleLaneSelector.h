@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+// Picks a random least-used lane in O(1). Always taking a least-used lane keeps every lane count within one of
+// the others, so the lanes only have to be split into "still at the low count" and "already one higher".
+// Lanes[0, NumLeastUsed) hold the low count, taking one swaps it past the boundary.
+struct UCFGMS_API FObstacleLaneSelector
+{
+    // Obstacle placements store the lane in a byte
+    static constexpr int32 MaxLanes = 255;
+
+    void Reset(int32 NumLanes);
+
+    int32 Pick(FRandomStream& Random)
+    {
+        if (NumLeastUsed == 0)
+        {
+            // Every lane has caught up, they are all least used again
+            NumLeastUsed = Lanes.Num();
+        }
+
+        const int32 Index = Random.RandRange(0, NumLeastUsed - 1);
+        const uint8 Lane = Lanes[Index];
+        --NumLeastUsed;
+        Lanes[Index] = Lanes[NumLeastUsed];
+        Lanes[NumLeastUsed] = Lane;
+        return Lane;
+    }
+
+    int32 GetNumLanes() const { return Lanes.Num(); }
+
+private:
+    TArray<uint8, TInlineAllocator<8>> Lanes;
+    int32 NumLeastUsed = 0;
+};
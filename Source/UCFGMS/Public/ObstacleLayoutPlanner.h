@@ -0,0 +1,109 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+struct FObstacleSpawnParameters;
+class FObstaclePatternLibrary;
+
+// One obstacle of a planned chunk. Lanes are resolved to positions only when the obstacle is spawned
+struct FObstaclePlacement
+{
+    float Y = 0.0f;
+    // Height of the track surface relative to the lane position, filled in by ground snapping
+    float GroundOffsetZ = 0.0f;
+    uint16 TypeIndex = 0;
+    uint8 LaneIndex = 0;
+    uint8 bSpawnPlane : 1;
+
+    FObstaclePlacement()
+        : bSpawnPlane(false)
+    {
+    }
+};
+
+// Plans, pending batches and the entity store hold many of these, keep them small when adding fields
+static_assert(sizeof(FObstaclePlacement) == 12, "FObstaclePlacement grew, check that the new size is intended and update this");
+
+// A planned stretch of track, handed from the planning thread to the game thread
+struct FPlannedChunk
+{
+    int32 ChunkIndex = 0;
+    float StartY = 0.0f;
+    // Where the chunk after this one starts
+    float EndY = 0.0f;
+    TArray<FObstaclePlacement> Placements;
+};
+
+// What planning needs to know about an obstacle type, copied out of FObstacleSpawnInfo
+struct FObstacleTypeLayout
+{
+    // Extent along the track relative to the spawn Y
+    float FootprintMinY = 0.0f;
+    float FootprintMaxY = 0.0f;
+    // Extra gap after this type on top of SpacingBetweenObstacles
+    float SpacingAfter = 0.0f;
+    float PlaneSpawnProbability = 0.0f;
+    bool bHasPlane = false;
+};
+
+// Decides lanes, types, Y positions and planes for a chunk without touching any UObject.
+// Compile on the game thread, then Plan can run anywhere as long as each thread brings its own random stream.
+class UCFGMS_API FObstacleLayoutPlanner
+{
+public:
+    // Length along the track assumed for a type whose footprint is not known yet, the fixed gap obstacles used to get
+    static constexpr float DefaultFootprintLength = 500.0f;
+
+    // Footprints holds one box per obstacle type in spawn-relative space, see FObstacleFootprintCache
+    void Compile(const FObstacleSpawnParameters& Parameters, const TArray<FBox>& Footprints);
+
+    // Compiles only when Parameters or Footprints differ from the last compile in anything planning uses
+    void CompileIfChanged(const FObstacleSpawnParameters& Parameters, const TArray<FBox>& Footprints);
+
+    // False when compiling Parameters and Footprints would change anything planning uses
+    bool IsCompiledFor(const FObstacleSpawnParameters& Parameters, const TArray<FBox>& Footprints) const;
+
+    // Each obstacle slot becomes a whole formation from Library with the given probability. Null turns patterns off
+    void SetPatterns(TSharedPtr<const FObstaclePatternLibrary, ESPMode::ThreadSafe> Library, float Probability);
+
+    // Returns the Y the following chunk should start at. Takes any allocator, so callers can plan into scratch memory
+    template <typename AllocatorType>
+    float Plan(float StartY, int32 NumLanes, FRandomStream& Random, TArray<FObstaclePlacement, AllocatorType>& OutPlacements) const
+    {
+        OutPlacements.SetNumUninitialized(GetMaxPlacements(), false);
+        int32 NumPlanned = 0;
+        const float EndY = PlanInto(StartY, NumLanes, Random, OutPlacements, NumPlanned);
+        OutPlacements.SetNum(NumPlanned, false);
+        return EndY;
+    }
+
+    int32 GetNumObstacles() const { return NumObstacles; }
+
+    // Most placements one Plan call can produce, more than GetNumObstacles() once patterns are set
+    int32 GetMaxPlacements() const;
+
+private:
+    // Writes up to GetMaxPlacements() placements
+    float PlanInto(float StartY, int32 NumLanes, FRandomStream& Random, TArrayView<FObstaclePlacement> OutPlacements, int32& OutNumPlanned) const;
+
+    static uint32 HashLayout(const FObstacleSpawnParameters& Parameters, const TArray<FBox>& Footprints);
+
+    // Weighted type pick in O(1) through the alias table
+    int32 PickType(FRandomStream& Random) const;
+
+    int32 NumObstacles = 0;
+    float SpacingBetweenObstacles = 0.0f;
+    TArray<FObstacleTypeLayout> Types;
+
+    // Alias table over the type weights: take column i with probability AliasProbability[i], otherwise AliasTypes[i]
+    TArray<float> AliasProbability;
+    TArray<uint16> AliasTypes;
+
+    TSharedPtr<const FObstaclePatternLibrary, ESPMode::ThreadSafe> PatternLibrary;
+    float PatternProbability = 0.0f;
+
+    uint32 CompiledHash = 0;
+    bool bCompiled = false;
+};
@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ObstacleOriginRebaseSubsystem.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnWorldOriginShifted, FVector, Offset);
+
+// Moves the world origin along the track so an endless run stays close to zero. The engine shifts every actor,
+// component and the physics scene in one pass, actors keeping world positions of their own shift them in ApplyWorldOffset
+UCLASS()
+class UCFGMS_API UObstacleOriginRebaseSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    // At the start of the next frame, before anything ticks, moves the origin under the player if they are
+    // further than Threshold from it along the track
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Origin")
+    void RequestRebase(float Threshold);
+
+    // Moves the origin DeltaY along the track right away, everything in the world ends up DeltaY closer to zero
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Origin")
+    bool RebaseOrigin(int32 DeltaY);
+
+    // Fires after every origin shift with the offset added to all world positions. Positions kept outside of actors,
+    // such as the Y a Blueprint spawns its next obstacles at, have to add it too
+    UPROPERTY(BlueprintAssignable, Category = "Obstacles|Origin")
+    FOnWorldOriginShifted OnWorldOriginShifted;
+
+private:
+    void HandleWorldTickStart(UWorld* InWorld, ELevelTick TickType, float DeltaSeconds);
+    void HandleWorldOriginOffset(UWorld* InWorld, FIntVector SrcOrigin, FIntVector DstOrigin);
+
+    FDelegateHandle WorldTickStartHandle;
+    FDelegateHandle WorldOriginOffsetHandle;
+
+    bool bRebaseRequested = false;
+    float RequestedThreshold = 0.0f;
+};
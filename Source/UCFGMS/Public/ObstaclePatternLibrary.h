@@ -0,0 +1,139 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ObstaclePatternLibrary.generated.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+// One obstacle of a hand-authored formation
+USTRUCT(BlueprintType)
+struct FObstaclePatternObstacle
+{
+    GENERATED_BODY()
+
+    // Index into the spawner's SpawnParameters.ObstacleTypes
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns", meta = (ClampMin = "0"))
+    int32 TypeIndex = 0;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns", meta = (ClampMin = "0", ClampMax = "254"))
+    int32 Lane = 0;
+
+    // Spawn Y relative to where the formation starts
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns")
+    float OffsetY = 0.0f;
+
+    // Spawns the type's plane with it, if the type has one
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns")
+    bool bSpawnPlane = false;
+};
+
+// A multi-lane formation, e.g. a train with a barrier next to it and a plane on top
+USTRUCT(BlueprintType)
+struct FObstaclePattern
+{
+    GENERATED_BODY()
+
+    // Only for designers, it is not exported
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns")
+    FName Name;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns")
+    TArray<FObstaclePatternObstacle> Obstacles;
+
+    // Track the formation takes up, whatever comes next starts SpacingBetweenObstacles after it
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns", meta = (ClampMin = "0"))
+    float Length = 2000.0f;
+
+    // How often the formation comes up relative to the others in the library
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Patterns", meta = (ClampMin = "0"))
+    float Weight = 1.0f;
+};
+
+// The file is these sections back to back, little-endian and 4-byte aligned:
+// header, pattern records, alias probabilities, alias patterns, obstacle records
+struct FObstaclePatternFileHeader
+{
+    static constexpr uint32 ExpectedMagic = 0x4C50424F; // "OBPL"
+    static constexpr uint32 CurrentVersion = 1;
+
+    uint32 Magic = ExpectedMagic;
+    uint32 Version = CurrentVersion;
+    uint32 NumPatterns = 0;
+    uint32 NumObstacles = 0;
+    // Most obstacles in any one pattern, lets planners size their output up front
+    uint32 MaxPatternObstacles = 0;
+};
+
+struct FObstaclePatternRecord
+{
+    uint32 FirstObstacle = 0;
+    uint16 NumObstacles = 0;
+    // Highest lane used plus one, tracks with fewer lanes skip the pattern
+    uint8 NumLanes = 0;
+    uint8 Padding = 0;
+    float Length = 0.0f;
+};
+
+struct FObstaclePatternRecordObstacle
+{
+    static constexpr uint8 SpawnPlaneFlag = 1;
+
+    float OffsetY = 0.0f;
+    uint16 TypeIndex = 0;
+    uint8 Lane = 0;
+    uint8 Flags = 0;
+};
+
+static_assert(sizeof(FObstaclePatternFileHeader) == 20, "The pattern file layout changed, bump CurrentVersion");
+static_assert(sizeof(FObstaclePatternRecord) == 12, "The pattern file layout changed, bump CurrentVersion");
+static_assert(sizeof(FObstaclePatternRecordObstacle) == 8, "The pattern file layout changed, bump CurrentVersion");
+
+// A read-only view over a pattern file. The file is memory-mapped where the platform allows it and read in one go
+// otherwise, nothing is created per pattern, so loading costs the same for ten patterns as for ten thousand
+class UCFGMS_API FObstaclePatternLibrary
+{
+public:
+    ~FObstaclePatternLibrary();
+
+    // Null when the file is missing, not a pattern file of the current version, or has a record pointing outside it
+    static TSharedPtr<const FObstaclePatternLibrary, ESPMode::ThreadSafe> Load(const FString& Filename);
+
+    // Serializes Patterns into the file format, with the alias table for weighted picks precomputed
+    static bool Write(const TArray<FObstaclePattern>& Patterns, TArray<uint8>& OutBytes);
+
+    int32 Num() const { return Patterns.Num(); }
+    int32 GetMaxPatternObstacles() const { return MaxPatternObstacles; }
+
+    // Weighted pick in O(1) through the alias table stored in the file
+    int32 Pick(FRandomStream& Random) const
+    {
+        const int32 Column = Random.RandRange(0, Patterns.Num() - 1);
+        const int32 Alias = static_cast<int32>(AliasPatterns[Column]);
+        return Random.GetFraction() < AliasProbability[Column] || Alias >= Patterns.Num() ? Column : Alias;
+    }
+
+    const FObstaclePatternRecord& GetPattern(int32 PatternIndex) const { return Patterns[PatternIndex]; }
+
+    // Bind checked every record against the file, so this never reads past the end
+    TArrayView<const FObstaclePatternRecordObstacle> GetObstacles(const FObstaclePatternRecord& Pattern) const
+    {
+        return Obstacles.Slice(static_cast<int32>(Pattern.FirstObstacle), Pattern.NumObstacles);
+    }
+
+private:
+    bool Bind(const uint8* Data, int64 Size, const FString& Filename);
+
+    // Whichever of these holds the file, the views below point into it
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+    TArray<uint8> FileData;
+
+    TArrayView<const FObstaclePatternRecord> Patterns;
+    TArrayView<const float> AliasProbability;
+    TArrayView<const uint32> AliasPatterns;
+    TArrayView<const FObstaclePatternRecordObstacle> Obstacles;
+    int32 MaxPatternObstacles = 0;
+};
@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "ObstaclePatternLibrary.h"
+#include "ObstaclePatternSet.generated.h"
+
+// Where designers author obstacle formations. The game never loads this asset, it reads the binary file exported
+// from it through FObstaclePatternLibrary
+UCLASS(BlueprintType)
+class UCFGMS_API UObstaclePatternSet : public UDataAsset
+{
+    GENERATED_BODY()
+
+public:
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Obstacles|Patterns")
+    TArray<FObstaclePattern> Patterns;
+
+    // Relative to the project content directory, the same path goes into the spawner's PatternLibraryFile
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Obstacles|Patterns")
+    FString ExportFile = TEXT("ObstaclePatterns/Patterns.obpl");
+
+#if WITH_EDITOR
+    // Writes Patterns to ExportFile in the format FObstaclePatternLibrary reads
+    UFUNCTION(CallInEditor, Category = "Obstacles|Patterns")
+    void ExportPatterns();
+#endif
+};
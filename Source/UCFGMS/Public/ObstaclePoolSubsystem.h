@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ObstaclePoolSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FObstaclePoolStats
+{
+    GENERATED_BODY()
+
+    // Acquisitions served by an actor that was already parked in the pool
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Obstacles|Pool")
+    int32 Hits = 0;
+
+    // Acquisitions that had to spawn a new actor
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Obstacles|Pool")
+    int32 Misses = 0;
+
+    // Actors currently handed out
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Obstacles|Pool")
+    int32 InUse = 0;
+
+    // Most actors handed out at the same time, use this to size PoolPrewarmCount
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Obstacles|Pool")
+    int32 HighWaterMark = 0;
+};
+
+USTRUCT()
+struct FObstacleActorPool
+{
+    GENERATED_BODY()
+
+    // Hidden, collision-less actors waiting to be handed out again
+    UPROPERTY()
+    TArray<TObjectPtr<AActor>> Parked;
+
+    UPROPERTY()
+    FObstaclePoolStats Stats;
+
+    // The class default, a reused actor gets this back rather than whatever its last use left behind
+    UPROPERTY()
+    bool bClassEnablesCollision = true;
+};
+
+// Per-class pools of obstacle actors so the endless track does not spawn and destroy actors for every obstacle
+UCLASS()
+class UCFGMS_API UObstaclePoolSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    // Spawns actors up front until the pool for ActorClass holds at least Count parked actors
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Pool")
+    void Prewarm(TSubclassOf<AActor> ActorClass, int32 Count);
+
+    // Hands out an actor of ActorClass at Transform, spawning a new one when the pool is empty. With bEnableCollision
+    // a reused actor gets the collision its class starts with, without it collision stays off for the caller to restore
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Pool")
+    AActor* Acquire(TSubclassOf<AActor> ActorClass, const FTransform& Transform, bool bEnableCollision = true);
+
+    // Acquire for spawn batches: collision stays off, and a pool miss is only spawned deferred. With
+    // bOutNeedsFinishSpawning set the caller has to call FinishSpawning(Transform) on it once the batch is placed,
+    // then turn collision on if bOutEnableCollision says the class has it
+    AActor* AcquireDeferred(TSubclassOf<AActor> ActorClass, const FTransform& Transform, bool& bOutNeedsFinishSpawning, bool& bOutEnableCollision);
+
+    // Hides the actor and parks it until it is acquired again
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Pool")
+    void Release(AActor* Actor);
+
+    // Destroys the parked actors of ActorClass, so the pool no longer keeps the class loaded. Actors in use stay theirs
+    void DropParked(TSubclassOf<AActor> ActorClass);
+
+    UFUNCTION(BlueprintPure, Category = "Obstacles|Pool")
+    FObstaclePoolStats GetPoolStats(TSubclassOf<AActor> ActorClass) const;
+
+    // Writes the counters of every pool to the log
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Pool")
+    void LogPoolStats() const;
+
+private:
+    FObstacleActorPool& FindOrAddPool(UClass* ActorClass);
+    AActor* AcquireInternal(UClass* ActorClass, const FTransform& Transform, bool bEnableCollision, bool bDeferSpawn, bool& bOutNeedsFinishSpawning, bool& bOutEnableCollision);
+    AActor* SpawnPooledActor(UClass* ActorClass, const FTransform& Transform, bool bDeferSpawn = false) const;
+    static void ParkActor(AActor* Actor);
+    static void ActivateActor(AActor* Actor, const FTransform& Transform, bool bEnableCollision);
+
+    UPROPERTY()
+    TMap<TObjectPtr<UClass>, FObstacleActorPool> Pools;
+
+    // Every actor in any Parked array, so a repeated Release is caught without scanning the pool
+    TSet<TObjectKey<AActor>> ParkedActors;
+};
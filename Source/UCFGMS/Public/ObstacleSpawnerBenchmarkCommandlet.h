@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ObstacleSpawnerBenchmarkCommandlet.generated.h"
+
+USTRUCT()
+struct FObstacleBenchmarkTimings
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    double MeanMs = 0.0;
+
+    UPROPERTY()
+    double P50Ms = 0.0;
+
+    UPROPERTY()
+    double P90Ms = 0.0;
+
+    UPROPERTY()
+    double P99Ms = 0.0;
+
+    UPROPERTY()
+    double MaxMs = 0.0;
+};
+
+// What one benchmark run writes, and what a baseline file holds
+USTRUCT()
+struct FObstacleBenchmarkReport
+{
+    GENERATED_BODY()
+
+    UPROPERTY()
+    int32 Seed = 0;
+
+    // Measured chunks, the warmup chunks before them are not in any of the numbers
+    UPROPERTY()
+    int32 Chunks = 0;
+
+    UPROPERTY()
+    int32 WarmupChunks = 0;
+
+    UPROPERTY()
+    int32 ObstaclesPerChunk = 0;
+
+    // Time of each SpawnObstaclesBatch call
+    UPROPERTY()
+    FObstacleBenchmarkTimings Spawn;
+
+    // Heap allocations made during the SpawnObstaclesBatch calls, averaged per chunk. Once pools and scratch
+    // arrays are warm there must be none, any at all fails the run
+    UPROPERTY()
+    double AllocationsPerChunk = 0.0;
+
+    UPROPERTY()
+    double AllocatedKBPerChunk = 0.0;
+
+    // Acquisitions of the pooled actor types over the whole run, the run fails without any hits
+    UPROPERTY()
+    int32 PoolHits = 0;
+
+    UPROPERTY()
+    int32 PoolMisses = 0;
+
+    // Full garbage collections run every GCInterval chunks, like the game would
+    UPROPERTY()
+    FObstacleBenchmarkTimings GarbageCollection;
+
+    UPROPERTY()
+    double StartUsedMB = 0.0;
+
+    UPROPERTY()
+    double EndUsedMB = 0.0;
+
+    UPROPERTY()
+    double PeakUsedMB = 0.0;
+
+    // Metrics worse than the baseline by more than the threshold, empty when the run passed
+    UPROPERTY()
+    TArray<FString> Regressions;
+};
+
+// Spawns thousands of obstacle chunks in a headless world with a fixed seed and writes the numbers as JSON.
+//   UnrealEditor-Cmd UCFGMS.uproject -run=ObstacleSpawnerBenchmark -nullrhi -unattended
+// Options: -Chunks=2000 -Warmup=100 -Seed=1337 -GCInterval=60 -Output=<json> -Baseline=<json> -Threshold=0.1 -WriteBaseline
+// Returns non-zero when a metric regressed against the baseline by more than Threshold, when the baseline is missing
+// or unreadable (unless -WriteBaseline), when the spawner never began play or never reused a pooled actor, or when
+// a measured chunk allocated on the heap.
+// No baseline is checked in, timings only compare on the machine they were recorded on. To bootstrap one, run with
+// -WriteBaseline on the reference machine and commit the Benchmarks/ObstacleSpawnerBaseline.json it writes
+UCLASS()
+class UCFGMS_API UObstacleSpawnerBenchmarkCommandlet : public UCommandlet
+{
+    GENERATED_BODY()
+
+public:
+    UObstacleSpawnerBenchmarkCommandlet();
+
+    virtual int32 Main(const FString& Params) override;
+
+private:
+    static void CompareToBaseline(const FObstacleBenchmarkReport& Baseline, float Threshold, FObstacleBenchmarkReport& Report);
+};
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+#include "Trace/Trace.h"
+
+// Per-obstacle text logging, silent unless raised with "log LogObstacleSpawner Verbose"
+UCFGMS_API DECLARE_LOG_CATEGORY_EXTERN(LogObstacleSpawner, Log, All);
+
+// "stat ObstacleSpawner" in the console shows everything the obstacle spawner spends per frame
+DECLARE_STATS_GROUP(TEXT("ObstacleSpawner"), STATGROUP_ObstacleSpawner, STATCAT_Advanced);
+
+// The same numbers for soak tests, "-csvCategories=ObstacleSpawner" with a CSV capture
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(UCFGMS_API, ObstacleSpawner);
+
+// Insights timing scopes of the spawner, "-trace=cpu,ObstacleSpawner"
+UE_TRACE_CHANNEL_EXTERN(ObstacleSpawnerChannel, UCFGMS_API);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Static Mesh Component"), STAT_SpawnStaticMeshComponent, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Skeletal Mesh Component"), STAT_SpawnSkeletalMeshComponent, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Recycled Components Reused"), STAT_RecycledComponentHits, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Recycled Components Created"), STAT_RecycledComponentMisses, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Parked Components"), STAT_ParkedComponents, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Instanced Obstacle"), STAT_SpawnInstancedObstacle, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Instanced Obstacles"), STAT_InstancedObstacles, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Instanced Obstacle Batches"), STAT_ObstacleInstanceBatches, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Process Pending Obstacles"), STAT_ProcessPendingObstacles, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Pending Obstacles Frame Ms"), STAT_PendingObstaclesFrameMs, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Pending Obstacles Spawned This Frame"), STAT_PendingObstaclesSpawnedThisFrame, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Prefetched Obstacle Assets"), STAT_PrefetchedObstacleAssets, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Obstacle Prefetch Misses"), STAT_ObstaclePrefetchMisses, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply Planned Chunk"), STAT_ApplyPlannedChunk, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Recycled Track Chunks"), STAT_RecycledTrackChunks, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Despawn Passed Obstacles"), STAT_DespawnPassedObstacles, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Tracked Obstacles"), STAT_TrackedObstacles, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Obstacle Actors"), STAT_LiveObstacleActors, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Live Obstacle Components"), STAT_LiveObstacleComponents, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Despawned Obstacles"), STAT_DespawnedObstacles, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Obstacles"), STAT_SpawnObstacles, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Obstacles Per Spawn Call"), STAT_ObstaclesPerSpawnCall, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Obstacle Actor"), STAT_SpawnObstacleActor, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Spawn Plane"), STAT_SpawnPlane, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Plane Spawns"), STAT_PlaneSpawns, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Actors In Use"), STAT_PooledActorsInUse, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pooled Actors Parked"), STAT_PooledActorsParked, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tick Movers"), STAT_TickMovers, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Awake Movers"), STAT_AwakeMovers, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Update Tick LOD"), STAT_UpdateTickLOD, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Tick LOD Full Rate"), STAT_TickLODFullRate, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Tick LOD Reduced"), STAT_TickLODReduced, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Tick LOD Suspended"), STAT_TickLODSuspended, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Rebase World Origin"), STAT_RebaseWorldOrigin, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("World Origin Rebases"), STAT_WorldOriginRebases, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Promote Obstacle Entities"), STAT_PromoteObstacleEntities, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Obstacle Entities"), STAT_ObstacleEntities, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Promoted Obstacle Entities"), STAT_PromotedObstacleEntities, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve Ground Snaps"), STAT_ResolveGroundSnaps, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Ground Snap Traces"), STAT_GroundSnapTraces, STATGROUP_ObstacleSpawner, UCFGMS_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Ground Snap Misses"), STAT_GroundSnapMisses, STATGROUP_ObstacleSpawner, UCFGMS_API);
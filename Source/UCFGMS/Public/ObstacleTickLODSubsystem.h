@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ObstacleTickLODSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FTickLODBucket
+{
+    GENERATED_BODY()
+
+    // Actors up to this far from the player along the track fall into this bucket
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Tick LOD", meta = (ClampMin = "0"))
+    float MaxDistance = 0.0f;
+
+    // 0 ticks every frame
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Tick LOD", meta = (ClampMin = "0", Units = "s"))
+    float TickInterval = 0.0f;
+
+    // Holds the actor tick back altogether, components keep ticking at the slowest interval of the other buckets
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Tick LOD")
+    bool bSuspendTick = false;
+};
+
+// Lowers the tick rate of movers and obstacle actors with their distance from the player along the track,
+// and restores it as the player gets close. Actors past the last bucket are suspended.
+// Only tick intervals are changed here. Whether the tick is enabled stays with the actor and the pool, so a mover
+// that went to sleep at rest stays asleep whichever bucket it is in.
+UCLASS()
+class UCFGMS_API UObstacleTickLODSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    UObstacleTickLODSubsystem();
+
+    virtual void Deinitialize() override;
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+
+    // Buckets ordered by MaxDistance, nearest first
+    UFUNCTION(BlueprintCallable, Category = "Obstacles|Tick LOD")
+    void SetBuckets(const TArray<FTickLODBucket>& InBuckets);
+
+    void Register(AActor* Actor);
+
+    // Gives the actor its own tick settings back
+    void Unregister(AActor* Actor);
+
+    // Interval of the bucket the actor is in, 0 while it is not registered or not bucketed yet.
+    // For work done on the actor's behalf without its own tick, e.g. batched movers
+    float GetUpdateInterval(const AActor* Actor) const;
+
+    // Registered actors per bucket, the extra last entry counts actors beyond every bucket
+    UFUNCTION(BlueprintPure, Category = "Obstacles|Tick LOD")
+    TArray<int32> GetBucketCounts() const { return BucketCounts; }
+
+    // Actors re-bucketed per frame, the rest keep their bucket until their turn comes round
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Obstacles|Tick LOD", meta = (ClampMin = "1"))
+    int32 MaxActorsPerFrame = 256;
+
+private:
+    struct FEntry
+    {
+        TWeakObjectPtr<AActor> Actor;
+        float OriginalTickInterval = 0.0f;
+        // Each component's own interval, they need not match the actor's
+        TArray<TPair<TWeakObjectPtr<UActorComponent>, float>> OriginalComponentIntervals;
+        int32 Bucket = INDEX_NONE;
+    };
+
+    int32 FindBucket(float Distance) const;
+    float GetBucketInterval(int32 Bucket) const;
+    void ApplyBucket(FEntry& Entry, int32 Bucket);
+    void RemoveEntry(int32 Index);
+    void UpdateCounters() const;
+
+    TArray<FTickLODBucket> Buckets;
+    TArray<FEntry> Entries;
+    TMap<TObjectKey<AActor>, int32> EntryIndices;
+    TArray<int32> BucketCounts;
+    int32 NextEntry = 0;
+};
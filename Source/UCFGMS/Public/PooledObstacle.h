@@ -0,0 +1,29 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Interface.h"
+#include "PooledObstacle.generated.h"
+
+UINTERFACE(BlueprintType)
+class UCFGMS_API UPooledObstacle : public UInterface
+{
+    GENERATED_BODY()
+};
+
+// Lets a pooled actor reset the state it captured in BeginPlay, which only runs for the first use.
+// UObstaclePoolSubsystem calls these on every actor class that implements the interface
+class UCFGMS_API IPooledObstacle
+{
+    GENERATED_BODY()
+
+public:
+    // Called once the actor is at its new transform, visible again and about to be handed out
+    UFUNCTION(BlueprintNativeEvent, Category = "Obstacles|Pool")
+    void OnAcquiredFromPool();
+
+    // Called when the actor is hidden and parked, including right after a prewarm spawn
+    UFUNCTION(BlueprintNativeEvent, Category = "Obstacles|Pool")
+    void OnParkedInPool();
+};